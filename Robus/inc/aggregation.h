@@ -0,0 +1,30 @@
+/******************************************************************************
+ * @file aggregation
+ * @brief pack several small messages into one Robus frame
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#ifndef _AGGREGATION_H_
+#define _AGGREGATION_H_
+
+#include <stdint.h>
+#include "robus_struct.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+void Aggr_Init(void);
+void Aggr_Loop(void);
+error_return_t Aggr_AddMsg(ll_container_t *ll_container, uint16_t node_id, msg_t *msg);
+error_return_t Aggr_Flush(void);
+void Aggr_Unpack(msg_t *msg);
+
+#endif /* _AGGREGATION_H_ */
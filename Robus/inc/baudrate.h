@@ -0,0 +1,31 @@
+/******************************************************************************
+ * @file baudrate
+ * @brief Robus baudrate management and negotiation
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#ifndef _BAUDRATE_H_
+#define _BAUDRATE_H_
+
+#include <stdint.h>
+#include "robus_struct.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+void Baud_Init(void);
+void Baud_Set(uint32_t baudrate);
+uint32_t Baud_Get(void);
+void Baud_Loop(void);
+error_return_t Baud_MsgHandler(ll_container_t *ll_container, msg_t *input);
+uint32_t Baud_Negotiate(ll_container_t *ll_container, uint16_t node_nbr, const uint32_t *baudrates, uint8_t baudrate_nbr);
+
+#endif /* _BAUDRATE_H_ */
@@ -21,24 +21,118 @@
 #define TIMEOUT_VAL 2
 #define MAX_ALIAS_SIZE 16
 #define MAX_DATA_MSG_SIZE 128
-#define MAX_MULTICAST_ADDRESS 1
+
+#ifndef MAX_FRAME_DATA_SIZE
+#define MAX_FRAME_DATA_SIZE MAX_DATA_MSG_SIZE // biggest data field of a frame (MTU), bigger than MAX_DATA_MSG_SIZE it is only available on messages allocated into msg_buffer
+#endif
+
+#if (MAX_FRAME_DATA_SIZE < MAX_DATA_MSG_SIZE) || (MAX_FRAME_DATA_SIZE > 1024)
+#error "MAX_FRAME_DATA_SIZE must be between MAX_DATA_MSG_SIZE and 1024"
+#endif
+
+#ifndef MAX_MULTICAST_ADDRESS
+#define MAX_MULTICAST_ADDRESS 4
+#endif
+
+#ifndef BAUD_TEST_WINDOW_MS
+#define BAUD_TEST_WINDOW_MS 100 // time given to the baudrate test before going back to the previous baudrate
+#endif
+
+#ifndef BAUD_PATTERN_NBR
+#define BAUD_PATTERN_NBR 8 // number of test pattern messages sent to validate a baudrate
+#endif
+
+#ifndef AGGREGATION_WINDOW_US
+#define AGGREGATION_WINDOW_US 1000 // maximum time a message wait for others to be packed into the same frame
+#endif
+
+#ifndef BULK_WINDOW_NB
+#define BULK_WINDOW_NB 8 // number of chunks sent by Luos_SendData before waiting for an acknowledgment (32 max)
+#endif
+#if (BULK_WINDOW_NB > 32)
+#error "BULK_WINDOW_NB can't exceed 32, the bulk acknowledgment have one bit per chunk in a uint32_t"
+#endif
+
+#ifndef BULK_ACK_TIMEOUT_MS
+#define BULK_ACK_TIMEOUT_MS 10 // time to wait for a bulk acknowledgment before sending the missing chunks again
+#endif
+
+#ifndef NBR_BULK_RETRY
+#define NBR_BULK_RETRY 5
+#endif
 
 #ifndef NBR_NAK_RETRY
 #define NBR_NAK_RETRY 10
 #endif
 
+#ifndef COLLISION_BACKOFF
+#define COLLISION_BACKOFF EXPONENTIAL_BACKOFF
+#endif
+
+#ifndef BACKOFF_SLOT_US
+#define BACKOFF_SLOT_US 10 // backoff window unit in us
+#endif
+
+#ifndef BACKOFF_MAX_EXPONENT
+#define BACKOFF_MAX_EXPONENT 6 // the backoff window stop growing after this number of collisions
+#endif
+
 #ifndef MAX_CONTAINER_NUMBER
 #define MAX_CONTAINER_NUMBER 5
 #endif
 
 #ifndef MSG_BUFFER_SIZE
-#define MSG_BUFFER_SIZE 3 * sizeof(msg_t)
+#define MSG_BUFFER_SIZE 3 * (sizeof(header_t) + MAX_FRAME_DATA_SIZE)
+#endif
+
+#ifndef CONTAINER_MAP_SIZE
+#define CONTAINER_MAP_SIZE 16 // power of 2, at least 2 * MAX_CONTAINER_NUMBER
+#endif
+
+#ifndef MULTICAST_MAP_SIZE
+#define MULTICAST_MAP_SIZE 64 // power of 2, at least 2 * MAX_CONTAINER_NUMBER * MAX_MULTICAST_ADDRESS
 #endif
 
 #ifndef MAX_MSG_NB
 #define MAX_MSG_NB 2 * MAX_CONTAINER_NUMBER
 #endif
 
+#ifndef AGGREGATION_MAX_MSG_NB
+#define AGGREGATION_MAX_MSG_NB (MAX_MSG_NB / 2) // maximum number of messages packed into a frame, the receiver need a luos task for each of them
+#endif
+
+#ifndef MAX_TX_MSG_NB
+#define MAX_TX_MSG_NB 2 // power of 2, number of messages waiting for transmission
+#endif
+
+#ifndef MAX_PINNED_MSG
+#define MAX_PINNED_MSG 4 // number of messages pinned one by one, a batch of Luos_ReadMsgBatch is pinned apart whatever its size
+#endif
+
+#ifndef HIGH_PRIORITY_TASK_NB
+#define HIGH_PRIORITY_TASK_NB 2
+#endif
+
+#ifndef HIGH_PRIORITY_BUFFER_SIZE
+#define HIGH_PRIORITY_BUFFER_SIZE (MSG_BUFFER_SIZE / 8)
+#endif
+
+#ifndef MSG_OVERFLOW_POLICY
+#define MSG_OVERFLOW_POLICY DROP_OLDEST
+#endif
+
+#ifndef CRC_HAL
+#define CRC_HAL FALSE // TRUE to compute CRC with LuosHAL_ComputeCRC (CRC hardware unit)
+#endif
+
+#ifndef US_TICK_HAL
+#define US_TICK_HAL FALSE // TRUE to get the us clock from LuosHAL_GetUsTick (hardware timer)
+#endif
+
+#ifndef TIMING_CALIBRATION_MS
+#define TIMING_CALIBRATION_MS 2 // duration of the delay loop calibration at init when US_TICK_HAL is FALSE
+#endif
+
 #ifndef NBR_PORT
 #define NBR_PORT 2
 #endif
@@ -0,0 +1,27 @@
+/******************************************************************************
+ * @file crc
+ * @brief Robus CRC computation
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#ifndef _CRC_H_
+#define _CRC_H_
+
+#include <stdint.h>
+#include "config.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define CRC_INIT_VAL 0xFFFF
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+uint16_t Crc_Update(uint16_t crc, const uint8_t *buf, uint16_t len);
+
+#endif /* _CRC_H_ */
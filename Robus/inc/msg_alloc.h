@@ -13,6 +13,7 @@
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+typedef uint32_t container_mask_t; /*!< One bit per ll_container index. */
 
 /*******************************************************************************
  * Variables
@@ -25,24 +26,36 @@ extern volatile msg_t *current_msg;
 // generic functions
 void MsgAlloc_Init(memory_stats_t *memory_stats);
 void MsgAlloc_loop(void);
+void MsgAlloc_SetOverflowPolicy(overflow_policy_t policy);
+void MsgAlloc_SetHighPriorityCmdNb(uint8_t cmd_nb);
 
 // msg buffering functions
-void MsgAlloc_ValidHeader(uint8_t valid, uint16_t data_size);
+error_return_t MsgAlloc_ValidHeader(uint8_t valid, uint16_t data_size);
 void MsgAlloc_InvalidMsg(void);
 void MsgAlloc_EndMsg(void);
 void MsgAlloc_SetData(uint8_t data);
-void MsgAlloc_SetMessage(msg_t *msg);
+void MsgAlloc_SetDataBlock(const uint8_t *data, uint16_t size);
+error_return_t MsgAlloc_SetMessage(msg_t *msg);
+error_return_t MsgAlloc_ReserveMsg(uint16_t data_size, msg_t **reserved);
+error_return_t MsgAlloc_AllocMsgToInterpret(uint16_t data_size, msg_t **allocated);
+error_return_t MsgAlloc_CommitMsg(msg_t *msg);
+void MsgAlloc_CancelMsg(msg_t *msg);
 error_return_t MsgAlloc_IsEmpty(void);
 void MsgAlloc_UsedMsgEnd(void);
+error_return_t MsgAlloc_PinMsg(msg_t *msg);
+error_return_t MsgAlloc_UnpinMsg(msg_t *msg);
 
 // msg interpretation task stack
 error_return_t MsgAlloc_PullMsgToInterpret(msg_t **returned_msg);
 
 // Luos task stack
 void MsgAlloc_LuosTaskAlloc(ll_container_t *container_concerned_by_current_msg, msg_t *concerned_msg);
+void MsgAlloc_LuosSharedTaskAlloc(container_mask_t container_mask, msg_t *concerned_msg);
 
 // Luos task research and pull
 error_return_t MsgAlloc_PullMsg(ll_container_t *target_container, msg_t **returned_msg);
+uint16_t MsgAlloc_PullMsgBatch(ll_container_t *target_container, msg_t **returned_msgs, uint16_t max_nbr);
+error_return_t MsgAlloc_UnpinMsgBatch(ll_container_t *target_container);
 error_return_t MsgAlloc_PullMsgFromLuosTask(uint16_t luos_task_id, msg_t **returned_msg);
 error_return_t MsgAlloc_LookAtLuosTask(uint16_t luos_task_id, ll_container_t **allocated_container);
 error_return_t MsgAlloc_GetLuosTaskSourceId(uint16_t luos_task_id, uint16_t *source_id);
@@ -43,6 +43,8 @@ typedef struct
 // Callbacks reception
 void Recep_GetHeader(volatile uint8_t *data);
 void Recep_GetData(volatile uint8_t *data);
+void Recep_GetDiscard(volatile uint8_t *data);
+void Recep_GetNak(volatile uint8_t *data);
 void Recep_GetCollision(volatile uint8_t *data);
 void Recep_Drop(volatile uint8_t *data);
 
@@ -50,11 +52,13 @@ void Recep_Drop(volatile uint8_t *data);
 void Recep_CatchAck(volatile uint8_t *data);
 
 void Recep_Init(void);
+void Recep_ProcessBlock(const uint8_t *buf, uint16_t len);
 void Recep_EndMsg(void);
 void Recep_Reset(void);
 void Recep_Timeout(void);
 void Recep_InterpretMsgProtocol(msg_t *msg);
 uint8_t Recep_NodeConcerned(header_t *header);
+uint8_t Recep_CmdConcerned(header_t *header);
 ll_container_t *Recep_GetConcernedLLContainer(header_t *header);
 
 #endif /* _RECEPTION_H_ */
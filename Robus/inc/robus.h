@@ -25,8 +25,17 @@ void Robus_Loop(void);
 ll_container_t *Robus_ContainerCreate(uint16_t type);
 void Robus_ContainersClear(void);
 error_return_t Robus_SendMsg(ll_container_t *ll_container, msg_t *msg);
+error_return_t Robus_SendMsgAsync(ll_container_t *ll_container, msg_t *msg, TX_CB tx_cb, uint16_t *tx_id);
+tx_status_t Robus_GetTxStatus(uint16_t tx_id);
+error_return_t Robus_AggregateMsg(ll_container_t *ll_container, uint16_t node_id, msg_t *msg);
+error_return_t Robus_FlushAggregation(void);
+void Robus_CatchMsg(ll_container_t *ll_container, uint8_t cmd, msg_t *msg);
+uint8_t Robus_MsgCaught(void);
 uint16_t Robus_TopologyDetection(ll_container_t *ll_container);
 node_t *Robus_GetNode(void);
+robus_stats_t *Robus_GetStats(void);
+void Robus_SetBaudrate(uint32_t baudrate);
+uint32_t Robus_NegotiateBaudrate(ll_container_t *ll_container, const uint32_t *baudrates, uint8_t baudrate_nbr);
 void Robus_DelayUs(uint32_t delay);
 
 #endif /* _ROBUS_H_ */
@@ -13,6 +13,10 @@
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+#define CMD_FILTER_SIZE (256 / 32)
+#define ROBUS_EXTENSION_CMD 0xF0 // first cmd of the Robus protocol extensions, cmds from here to 0xFF are reserved
+
+#define IS_ROBUS_CMD(cmd) (((cmd) < ROBUS_PROTOCOL_NB) || ((cmd) >= ROBUS_EXTENSION_CMD))
 
 /******************************************************************************
  * @struct memory_stats_t
@@ -22,15 +26,75 @@ typedef struct __attribute__((__packed__))
 {
     uint8_t msg_stack_ratio;
     uint8_t luos_stack_ratio;
-    uint8_t msg_drop_number;
+    uint16_t buffer_evict_drop; /*!< Pending messages overwritten to receive new ones (DROP_OLDEST). */
+    uint16_t task_evict_drop;   /*!< Pending messages removed because msg_tasks or luos_tasks is full (DROP_OLDEST). */
+    uint16_t buffer_full_drop;  /*!< Received messages dropped because msg_buffer is full (DROP_NEWEST, BACKPRESSURE). */
+    uint16_t task_full_drop;    /*!< Received messages dropped because msg_tasks or luos_tasks is full (DROP_NEWEST, BACKPRESSURE). */
+    uint16_t nak_number;        /*!< Received messages refused with a NAK because there is no space to save them. */
 } memory_stats_t;
 
+/******************************************************************************
+ * @struct robus_stats_t
+ * @brief store informations about reception and bus health
+ ******************************************************************************/
+typedef struct __attribute__((__packed__))
+{
+    union
+    {
+        struct __attribute__((__packed__))
+        {
+            uint32_t rx_frame_nbr;      /*!< Received frames concerning this node with a valid CRC. */
+            uint16_t crc_error_nbr;     /*!< Received frames concerning this node with a wrong CRC. */
+            uint16_t framing_error_nbr; /*!< Received frames dropped because of a framing error. */
+            uint16_t timeout_nbr;       /*!< Receptions interrupted before the end of the frame or the ack. */
+            uint16_t collision_nbr;     /*!< Collisions detected during a transmission. */
+            uint16_t filter_drop_nbr;   /*!< Received frames dropped because no container of this node want it. */
+            uint32_t backoff_time;      /*!< Total time waited before retrying after a collision in us. */
+        };
+        uint8_t unmap[18]; /*!< streamable form. */
+    };
+} robus_stats_t;
+
+/******************************************************************************
+ * @enum overflow_policy_t
+ * @brief Message allocator behavior when there is no more space for a new message
+ ******************************************************************************/
+typedef enum
+{
+    DROP_OLDEST,  /*!< Remove the oldest pending messages to save the new one. */
+    DROP_NEWEST,  /*!< Keep the pending messages and drop the new one. */
+    BACKPRESSURE, /*!< Keep the pending messages and NAK the new one if possible allowing the sender to retry later. */
+} overflow_policy_t;
+
+/******************************************************************************
+ * @enum backoff_policy_t
+ * @brief Waiting time before retrying a transmission after a collision
+ ******************************************************************************/
+typedef enum
+{
+    ID_BACKOFF,          /*!< Wait (ID - 1) * retry us, lowest IDs always win. */
+    EXPONENTIAL_BACKOFF, /*!< Wait a random time into a window doubling at each retry (truncated binary exponential backoff). */
+    PRIORITY_BACKOFF,    /*!< Exponential backoff with a window halved for HIGH_PRIORITY containers. */
+} backoff_policy_t;
+
+/******************************************************************************
+ * @enum msg_priority_t
+ * @brief Message interpretation priority
+ ******************************************************************************/
+typedef enum
+{
+    NORMAL_PRIORITY, /*!< Messages interpreted in arrival order. */
+    HIGH_PRIORITY,   /*!< Messages interpreted before normal ones, with reserved space. */
+    PRIORITY_NB
+} msg_priority_t;
+
 typedef struct __attribute__((__packed__))
 {
     uint8_t msg_nbr;
     uint8_t fail_msg_nbr;
     uint8_t *max_collision_retry;
     uint8_t *max_nak_retry;
+    uint8_t *msg_drop_nbr;
 } ll_stats_t;
 /*
  * This structure is used to get the message addressing mode list.
@@ -97,6 +161,12 @@ typedef struct __attribute__((__packed__))
     uint16_t max_multicast_target;                         /*!< Position pointer of the last multicast target. */
     uint16_t multicast_target_bank[MAX_MULTICAST_ADDRESS]; /*!< multicast target bank. */
     uint16_t dead_container_spotted;                       /*!< The ID of a container that don't reply to a lot of ACK msg */
+    uint8_t coalescing;                                    /*!< If true a new message replace the pending one with the same source and cmd. */
+    uint8_t quota_min_task;                                /*!< Number of luos_tasks reserved for this container. */
+    uint8_t quota_max_task;                                /*!< Maximum number of pending luos_tasks, 0 for no limit. */
+    uint16_t quota_max_byte;                               /*!< Maximum size of pending messages into msg_buffer, 0 for no limit. */
+    uint8_t priority;                                      /*!< Priority of the messages received by this container. */
+    uint32_t cmd_filter[CMD_FILTER_SIZE];                  /*!< One bit per accepted cmd, messages with other cmds are dropped at reception. */
 
     //variable stat on robus com for ll_container
     ll_stats_t ll_stat;
@@ -141,9 +211,29 @@ typedef enum
     SET_BAUDRATE,    /*!< Set Robus baudrate*/
     ASSERT,          /*!< Node Assert message (only broadcast with a source as a node */
     ROBUS_PROTOCOL_NB,
+
+    // protocol extensions, at the end of the cmd range to keep the value of the other cmds
+    BAUDRATE_TEST = ROBUS_EXTENSION_CMD, /*!< Switch to a baudrate until it is committed or the test window is over. */
+    BAUDRATE_PATTERN,                    /*!< Test pattern sent during a baudrate test. */
+    BAUDRATE_REPORT,                     /*!< Ask(size == 0) or reply(size > 0) the result of a baudrate test. */
+    BAUDRATE_COMMIT,                     /*!< Keep the tested baudrate. */
+    AGGREGATE,                           /*!< Frame containing several messages for containers of the same node. */
 } robus_cmd_t;
 
+/******************************************************************************
+ * @enum tx_status_t
+ * @brief Transmission status of a message sent with Robus_SendMsgAsync
+ ******************************************************************************/
+typedef enum
+{
+    TX_PENDING, /*!< Message waiting for transmission or acknowledgment. */
+    TX_SUCCEED, /*!< Message sent (and acknowledged if needed). */
+    TX_FAILED,  /*!< Message lost because of collisions, missing ack or localhost space. */
+    TX_UNKNOWN  /*!< Status not available anymore, it have been replaced by a newer message. */
+} tx_status_t;
+
 typedef void (*RX_CB)(ll_container_t *ll_container, msg_t *msg);
+typedef void (*TX_CB)(ll_container_t *ll_container, uint16_t tx_id, error_return_t result);
 /*******************************************************************************
  * Variables
  ******************************************************************************/
@@ -1,6 +1,6 @@
 /******************************************************************************
  * @file target
- * @brief multicast protocole description
+ * @brief multicast protocole description and target filtering
  * @author Luos
  * @version 0.0.0
  ******************************************************************************/
@@ -8,6 +8,7 @@
 #define _TARGET_H_
 
 #include "context.h"
+#include "msg_alloc.h"
 
 /*******************************************************************************
  * Definitions
@@ -21,6 +22,18 @@
  * Function
  ******************************************************************************/
 uint8_t Trgt_MulticastTargetBank(ll_container_t *ll_container, uint16_t val);
-void Trgt_AddMulticastTarget(ll_container_t *ll_container, uint16_t target);
+error_return_t Trgt_AddMulticastTarget(ll_container_t *ll_container, uint16_t target);
+error_return_t Trgt_RemoveMulticastTarget(ll_container_t *ll_container, uint16_t target);
+uint8_t Trgt_MulticastConcerned(uint16_t target);
+container_mask_t Trgt_GetMulticastMask(uint16_t target);
+void Trgt_Init(void);
+void Trgt_UpdateFilters(void);
+uint8_t Trgt_IdConcerned(uint16_t id);
+ll_container_t *Trgt_GetContainerFromId(uint16_t id);
+container_mask_t Trgt_GetTypeMask(uint16_t type);
+ll_container_t *Trgt_GetContainerFromType(uint16_t type);
+void Trgt_SetCmdFilter(ll_container_t *ll_container, const uint32_t *cmd_filter);
+uint8_t Trgt_CmdAccepted(ll_container_t *ll_container, uint8_t cmd);
+container_mask_t Trgt_CmdFilterMask(container_mask_t container_mask, uint8_t cmd);
 
 #endif /* _TARGET_H_ */
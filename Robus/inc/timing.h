@@ -0,0 +1,42 @@
+/******************************************************************************
+ * @file timing
+ * @brief Robus microsecond clock, delays and deadlines
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+#include <stdint.h>
+#include "config.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+typedef struct
+{
+    uint32_t start;    /*!< Date of the deadline start in us. */
+    uint32_t duration; /*!< Time before expiration in us. */
+} deadline_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+#if (US_TICK_HAL == TRUE)
+// Free running microsecond counter, to be provided by the HAL
+uint32_t LuosHAL_GetUsTick(void);
+#endif
+
+void Timing_Init(void);
+uint32_t Timing_GetUs(void);
+void Timing_DelayUs(uint32_t delay);
+void Timing_SetCalibration(uint32_t loop_per_ms);
+uint32_t Timing_GetCalibration(void);
+void Timing_SetDeadline(deadline_t *deadline, uint32_t delay);
+uint8_t Timing_IsExpired(deadline_t *deadline);
+
+#endif /* _TIMING_H_ */
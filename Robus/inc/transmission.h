@@ -28,5 +28,12 @@ typedef struct
 void Transmit_SendAck(void);
 error_return_t Transmit_Process(uint8_t *data, uint16_t size);
 void Transmit_WaitUnlockTx(void);
+void Transmit_Init(void);
+uint8_t Transmit_IsFull(void);
+uint16_t Transmit_Enqueue(ll_container_t *ll_container, uint8_t *data, uint16_t size, uint8_t localhost, error_return_t result, TX_CB tx_cb);
+uint16_t Transmit_EnqueueRef(ll_container_t *ll_container, uint8_t *data, uint16_t size, uint8_t localhost, error_return_t result, TX_CB tx_cb, msg_t *pinned_msg);
+tx_status_t Transmit_GetStatus(uint16_t tx_id);
+void Transmit_Loop(void);
+void Transmit_SetBackoffPolicy(backoff_policy_t policy);
 
 #endif /* _TRANSMISSION_H_ */
@@ -0,0 +1,300 @@
+/******************************************************************************
+ * @file aggregation
+ * @brief pack several small messages into one Robus frame
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include "aggregation.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include "robus.h"
+#include "msg_alloc.h"
+#include "timing.h"
+#include "reception.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/*
+ * Each message packed into an AGGREGATE frame start with a sub-header.
+ * Target node, source and protocol are the ones of the frame.
+ *
+ * An ID message with at most SUB_SIZE_MASK data bytes and a target close to the
+ * one of the previous ID message of the frame (0 at the start of the frame)
+ * use a 2 bytes compact sub-header :
+ *   - byte 0 : SUB_FULL_FLAG cleared, signed target delta on bits 5-6, size on bits 0-4
+ *   - byte 1 : cmd
+ * The other messages use a full_sub_header_t.
+ */
+#define SUB_FULL_FLAG           0x80
+#define SUB_DELTA_SHIFT         5
+#define SUB_DELTA_MIN           (-2)
+#define SUB_DELTA_MAX           1
+#define SUB_SIZE_MASK           0x1F
+#define COMPACT_SUB_HEADER_SIZE 2
+
+typedef struct __attribute__((__packed__))
+{
+    union
+    {
+        struct __attribute__((__packed__))
+        {
+            uint8_t mode;    /*!< SUB_FULL_FLAG and targeting mode. */
+            uint16_t target; /*!< Target address. */
+            uint8_t cmd;     /*!< msg definition. */
+            uint8_t size;    /*!< Size of the data field. */
+        };
+        uint8_t unmap[5]; /*!< Unmaped form. */
+    };
+} full_sub_header_t;
+
+#define MAX_SUB_DATA_SIZE (MAX_DATA_MSG_SIZE - sizeof(full_sub_header_t))
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static msg_t aggr_msg;                    /*!< Frame being filled. */
+static ll_container_t *aggr_ll_container; /*!< Container sending aggr_msg, NULL if there is no pending frame. */
+static uint8_t aggr_sub_nbr;              /*!< Number of messages packed into aggr_msg. */
+static uint16_t aggr_prev_target;         /*!< Target of the last ID message packed into aggr_msg. */
+static deadline_t aggr_deadline;          /*!< Date to send aggr_msg even if it is not full. */
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief compute the size of the sub-header of a message packed after the previous ones
+ * @param header of the message
+ * @param prev_target target of the previous ID message of the frame
+ * @return sub-header size
+ ******************************************************************************/
+static uint16_t Aggr_SubHeaderSize(header_t *header, uint16_t prev_target)
+{
+    int16_t delta = (int16_t)header->target - (int16_t)prev_target;
+    if ((header->target_mode == ID) && (header->size <= SUB_SIZE_MASK) && (delta >= SUB_DELTA_MIN) && (delta <= SUB_DELTA_MAX))
+    {
+        return COMPACT_SUB_HEADER_SIZE;
+    }
+    return sizeof(full_sub_header_t);
+}
+/******************************************************************************
+ * @brief write the sub-header of a message packed after the previous ones
+ * @param buffer to write the sub-header to
+ * @param header of the message
+ * @param prev_target target of the previous ID message of the frame, updated for the next one
+ * @return sub-header size
+ ******************************************************************************/
+static uint16_t Aggr_PackSubHeader(uint8_t *buffer, header_t *header, uint16_t *prev_target)
+{
+    full_sub_header_t sub_header;
+    uint16_t size = Aggr_SubHeaderSize(header, *prev_target);
+    if (size == COMPACT_SUB_HEADER_SIZE)
+    {
+        uint8_t delta = (uint8_t)(header->target - *prev_target);
+        buffer[0] = (uint8_t)((delta << SUB_DELTA_SHIFT) & ~SUB_FULL_FLAG) | (uint8_t)header->size;
+        buffer[1] = header->cmd;
+    }
+    else
+    {
+        sub_header.mode = SUB_FULL_FLAG | header->target_mode;
+        sub_header.target = header->target;
+        sub_header.cmd = header->cmd;
+        sub_header.size = (uint8_t)header->size;
+        memcpy(buffer, sub_header.unmap, sizeof(full_sub_header_t));
+    }
+    if (header->target_mode == ID)
+    {
+        *prev_target = header->target;
+    }
+    return size;
+}
+/******************************************************************************
+ * @brief read the sub-header of a packed message
+ * @param buffer to read the sub-header from
+ * @param size of buffer
+ * @param header filled with the target, target_mode, cmd and size of the message
+ * @param prev_target target of the previous ID message of the frame, updated for the next one
+ * @return sub-header size, 0 if buffer is too small
+ ******************************************************************************/
+static uint16_t Aggr_UnpackSubHeader(const uint8_t *buffer, uint16_t size, header_t *header, uint16_t *prev_target)
+{
+    full_sub_header_t sub_header;
+    if ((size >= COMPACT_SUB_HEADER_SIZE) && !(buffer[0] & SUB_FULL_FLAG))
+    {
+        // Sign extend the target delta
+        int8_t delta = (int8_t)(buffer[0] << 1) >> (SUB_DELTA_SHIFT + 1);
+        header->target = *prev_target + delta;
+        header->target_mode = ID;
+        header->size = buffer[0] & SUB_SIZE_MASK;
+        header->cmd = buffer[1];
+        size = COMPACT_SUB_HEADER_SIZE;
+    }
+    else if (size >= sizeof(full_sub_header_t))
+    {
+        memcpy(sub_header.unmap, buffer, sizeof(full_sub_header_t));
+        header->target = sub_header.target;
+        header->target_mode = sub_header.mode & ~SUB_FULL_FLAG;
+        header->size = sub_header.size;
+        header->cmd = sub_header.cmd;
+        size = sizeof(full_sub_header_t);
+    }
+    else
+    {
+        header->size = 0;
+        return 0;
+    }
+    if (header->target_mode == ID)
+    {
+        *prev_target = header->target;
+    }
+    return size;
+}
+/******************************************************************************
+ * @brief init the aggregation
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Aggr_Init(void)
+{
+    aggr_ll_container = NULL;
+    aggr_sub_nbr = 0;
+}
+/******************************************************************************
+ * @brief send the pending frame at the end of the aggregation window
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Aggr_Loop(void)
+{
+    if ((aggr_ll_container != NULL) && Timing_IsExpired(&aggr_deadline))
+    {
+        Aggr_Flush();
+    }
+}
+/******************************************************************************
+ * @brief add a message to the frame sent to a node
+ * @param ll_container sending the message
+ * @param node_id node hosting the target of the message
+ * @param msg to send, it is copied and can be reused as soon as this function return
+ * @return FAILED if the message can't be queued
+ ******************************************************************************/
+error_return_t Aggr_AddMsg(ll_container_t *ll_container, uint16_t node_id, msg_t *msg)
+{
+    if ((msg->header.size > MAX_SUB_DATA_SIZE) || IS_ROBUS_CMD(msg->header.cmd) || (msg->header.target_mode == IDACK) || (msg->header.target_mode == NODEID) || (msg->header.target_mode == NODEIDACK))
+    {
+        // This message is too big, is a protocol one or need its own ack, send it alone after the pending ones
+        if (Aggr_Flush() == FAILED)
+        {
+            return FAILED;
+        }
+        return Robus_SendMsgAsync(ll_container, msg, NULL, NULL);
+    }
+    if ((aggr_ll_container != NULL) && ((aggr_ll_container != ll_container) || (aggr_msg.header.target != node_id) || (aggr_msg.header.size + Aggr_SubHeaderSize(&msg->header, aggr_prev_target) + msg->header.size > MAX_DATA_MSG_SIZE)))
+    {
+        // This message can't be added to the pending frame
+        if (Aggr_Flush() == FAILED)
+        {
+            return FAILED;
+        }
+    }
+    if (aggr_ll_container == NULL)
+    {
+        // Start a new frame
+        aggr_msg.header.target_mode = NODEID;
+        aggr_msg.header.target = node_id;
+        aggr_msg.header.cmd = AGGREGATE;
+        aggr_msg.header.size = 0;
+        aggr_ll_container = ll_container;
+        aggr_sub_nbr = 0;
+        aggr_prev_target = 0;
+        Timing_SetDeadline(&aggr_deadline, AGGREGATION_WINDOW_US);
+    }
+    aggr_msg.header.size += Aggr_PackSubHeader(&aggr_msg.data[aggr_msg.header.size], &msg->header, &aggr_prev_target);
+    memcpy(&aggr_msg.data[aggr_msg.header.size], msg->data, msg->header.size);
+    aggr_msg.header.size += msg->header.size;
+    aggr_sub_nbr++;
+    if ((aggr_msg.header.size + COMPACT_SUB_HEADER_SIZE > MAX_DATA_MSG_SIZE) || (aggr_sub_nbr >= AGGREGATION_MAX_MSG_NB))
+    {
+        // There is no more space for another message, send it now or on the next Aggr_Loop if the transmission queue is full.
+        // The message is already into the frame, so this is a success anyway.
+        Aggr_Flush();
+    }
+    return SUCCEED;
+}
+/******************************************************************************
+ * @brief send the pending frame
+ * @param None
+ * @return FAILED if the transmission queue is full, the frame stay pending
+ ******************************************************************************/
+error_return_t Aggr_Flush(void)
+{
+    msg_t msg;
+    uint16_t prev_target = 0;
+    if (aggr_ll_container == NULL)
+    {
+        return SUCCEED;
+    }
+    if (aggr_sub_nbr == 1)
+    {
+        // There is only one message, send it with a classic header
+        uint16_t index = Aggr_UnpackSubHeader(aggr_msg.data, aggr_msg.header.size, &msg.header, &prev_target);
+        memcpy(msg.data, &aggr_msg.data[index], msg.header.size);
+        if (Robus_SendMsgAsync(aggr_ll_container, &msg, NULL, NULL) == FAILED)
+        {
+            return FAILED;
+        }
+    }
+    else if (Robus_SendMsgAsync(aggr_ll_container, &aggr_msg, NULL, NULL) == FAILED)
+    {
+        return FAILED;
+    }
+    aggr_ll_container = NULL;
+    aggr_sub_nbr = 0;
+    return SUCCEED;
+}
+/******************************************************************************
+ * @brief split a received AGGREGATE frame into messages to interpret
+ * @param msg AGGREGATE frame
+ * @return None
+ ******************************************************************************/
+void Aggr_Unpack(msg_t *msg)
+{
+    msg_t frame;
+    msg_t *sub_msg;
+    header_t sub_header;
+    uint16_t prev_target = 0;
+    uint16_t sub_header_size;
+    uint16_t index = 0;
+    uint16_t size = msg->header.size;
+    if (size > MAX_DATA_MSG_SIZE)
+    {
+        return;
+    }
+    // Allocating the messages can release and overwrite the frame, work on a copy
+    memcpy(frame.stream, msg->stream, sizeof(header_t) + size);
+    while (index < size)
+    {
+        sub_header_size = Aggr_UnpackSubHeader(&frame.data[index], size - index, &sub_header, &prev_target);
+        index += sub_header_size;
+        if ((sub_header_size == 0) || (index + sub_header.size > size) || IS_ROBUS_CMD(sub_header.cmd))
+        {
+            // This frame is corrupted
+            return;
+        }
+        // Save this message as a received one and interpret it
+        if (MsgAlloc_AllocMsgToInterpret(sub_header.size, &sub_msg) == SUCCEED)
+        {
+            sub_msg->header.protocol = frame.header.protocol;
+            sub_msg->header.target = sub_header.target;
+            sub_msg->header.target_mode = sub_header.target_mode;
+            sub_msg->header.source = frame.header.source;
+            sub_msg->header.cmd = sub_header.cmd;
+            sub_msg->header.size = sub_header.size;
+            memcpy(sub_msg->data, &frame.data[index], sub_header.size);
+            Recep_InterpretMsgProtocol(sub_msg);
+        }
+        index += sub_header.size;
+    }
+}
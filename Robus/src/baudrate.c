@@ -0,0 +1,460 @@
+/******************************************************************************
+ * @file baudrate
+ * @brief Robus baudrate management and negotiation
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include "baudrate.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include "robus.h"
+#include "context.h"
+#include "timing.h"
+#include "luos_hal.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BAUD_PATTERN_SIZE 32         // data size of the test pattern messages
+#define BAUD_SETTLE_US 2000          // time given to all nodes to switch to the tested baudrate
+#define BAUD_REPORT_TIMEOUT_US 10000 // time given to a node to reply its test report
+#define BAUD_COMMIT_REPEAT 3         // number of commit (or fallback) rounds before giving up
+
+typedef enum
+{
+    BAUD_IDLE,   /*!< The current baudrate is validated. */
+    BAUD_TESTING /*!< A baudrate is tested, the previous one will be restored if it is not committed. */
+} baud_state_t;
+
+/*
+ * Sent by the negotiating node with BAUDRATE_TEST
+ */
+typedef struct __attribute__((__packed__))
+{
+    union
+    {
+        struct __attribute__((__packed__))
+        {
+            uint32_t baudrate;    /*!< Baudrate to test. */
+            uint16_t window_ms;   /*!< Time before going back to the previous baudrate without commit. */
+            uint16_t pattern_nbr; /*!< Number of pattern messages that will be sent. */
+        };
+        uint8_t unmap[8]; /*!< streamable form. */
+    };
+} baud_test_t;
+
+/*
+ * Replied by each node to a BAUDRATE_REPORT request
+ */
+typedef struct __attribute__((__packed__))
+{
+    union
+    {
+        struct __attribute__((__packed__))
+        {
+            uint32_t baudrate;    /*!< Tested baudrate. */
+            uint16_t node_id;     /*!< ID of the reporting node. */
+            uint16_t pattern_nbr; /*!< Number of valid pattern messages received. */
+            uint16_t error_nbr;   /*!< Reception errors (CRC, framing, timeout) during the test. */
+            uint8_t committed;    /*!< The tested baudrate is committed on this node. */
+        };
+        uint8_t unmap[11]; /*!< streamable form. */
+    };
+} baud_report_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t current_baudrate;        /*!< Current baudrate. */
+static uint32_t previous_baudrate;       /*!< Baudrate restored if the tested one is not committed. */
+static baud_state_t baud_state;          /*!< Negotiation state of this node. */
+static deadline_t test_deadline;         /*!< End of the test window. */
+static baud_report_t test_report;        /*!< Test result of this node. */
+static uint32_t test_error_ref;          /*!< Reception errors number at the test start. */
+static baud_report_t received_report;    /*!< Last report received by the negotiating node. */
+static volatile uint8_t report_received; /*!< True when received_report is filled. */
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+static uint8_t Baud_PatternByte(uint16_t index, uint16_t i);
+static uint32_t Baud_GetErrorNbr(void);
+static void Baud_StartTest(baud_test_t *test);
+static error_return_t Baud_TryRate(ll_container_t *ll_container, uint16_t node_nbr, uint32_t rate);
+static error_return_t Baud_GetReport(ll_container_t *ll_container, uint16_t node_id);
+static void Baud_Wait(uint32_t delay);
+
+/******************************************************************************
+ * @brief init baudrate management
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Baud_Init(void)
+{
+    current_baudrate = DEFAULTBAUDRATE;
+    previous_baudrate = DEFAULTBAUDRATE;
+    baud_state = BAUD_IDLE;
+    report_received = false;
+}
+/******************************************************************************
+ * @brief set the baudrate of this node
+ * @param baudrate
+ * @return None
+ ******************************************************************************/
+void Baud_Set(uint32_t baudrate)
+{
+    current_baudrate = baudrate;
+    LuosHAL_ComInit(baudrate);
+}
+/******************************************************************************
+ * @brief get the baudrate of this node
+ * @param None
+ * @return baudrate
+ ******************************************************************************/
+uint32_t Baud_Get(void)
+{
+    return current_baudrate;
+}
+/******************************************************************************
+ * @brief restore the previous baudrate if the tested one is not committed in time
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Baud_Loop(void)
+{
+    if ((baud_state == BAUD_TESTING) && Timing_IsExpired(&test_deadline))
+    {
+        baud_state = BAUD_IDLE;
+        Baud_Set(previous_baudrate);
+    }
+}
+/******************************************************************************
+ * @brief manage baudrate negotiation messages
+ * @param ll_container concerned by the message
+ * @param input message received
+ * @return error_return_t SUCCEED if the message have been consumed.
+ ******************************************************************************/
+error_return_t Baud_MsgHandler(ll_container_t *ll_container, msg_t *input)
+{
+    msg_t output_msg;
+    baud_test_t test;
+    uint32_t rate;
+    uint16_t i;
+    switch (input->header.cmd)
+    {
+    case BAUDRATE_TEST:
+        if (input->header.size == sizeof(baud_test_t))
+        {
+            memcpy(test.unmap, input->data, sizeof(baud_test_t));
+            Baud_StartTest(&test);
+        }
+        return SUCCEED;
+        break;
+    case BAUDRATE_PATTERN:
+        if ((baud_state != BAUD_TESTING) || (input->header.size != BAUD_PATTERN_SIZE))
+        {
+            return SUCCEED;
+        }
+        for (i = 0; i < BAUD_PATTERN_SIZE; i++)
+        {
+            if (input->data[i] != Baud_PatternByte(input->data[0], i))
+            {
+                // This pattern is corrupted
+                test_report.error_nbr++;
+                return SUCCEED;
+            }
+        }
+        test_report.pattern_nbr++;
+        return SUCCEED;
+        break;
+    case BAUDRATE_REPORT:
+        if (input->header.size == 0)
+        {
+            // The negotiating node ask for our test result
+            if (ctx.ll_container_number == 0)
+            {
+                return SUCCEED;
+            }
+            if (ll_container == NULL)
+            {
+                ll_container = (ll_container_t *)&ctx.ll_container_table[0];
+            }
+            test_report.node_id = ctx.node.node_id;
+            test_report.committed = (baud_state == BAUD_IDLE);
+            test_report.error_nbr += (uint16_t)(Baud_GetErrorNbr() - test_error_ref);
+            test_error_ref = Baud_GetErrorNbr();
+            output_msg.header.cmd = BAUDRATE_REPORT;
+            output_msg.header.target_mode = ID;
+            output_msg.header.target = input->header.source;
+            output_msg.header.size = sizeof(baud_report_t);
+            memcpy(output_msg.data, test_report.unmap, sizeof(baud_report_t));
+            Robus_SendMsg(ll_container, &output_msg);
+        }
+        else if (input->header.size == sizeof(baud_report_t))
+        {
+            // This is a node test result
+            memcpy(received_report.unmap, input->data, sizeof(baud_report_t));
+            report_received = true;
+        }
+        return SUCCEED;
+        break;
+    case BAUDRATE_COMMIT:
+        memcpy(&rate, input->data, sizeof(uint32_t));
+        if ((baud_state == BAUD_TESTING) && (rate == current_baudrate))
+        {
+            // The tested baudrate is validated by all nodes, keep it
+            baud_state = BAUD_IDLE;
+            previous_baudrate = current_baudrate;
+        }
+        return SUCCEED;
+        break;
+    default:
+        return FAILED;
+        break;
+    }
+    return FAILED;
+}
+/******************************************************************************
+ * @brief find the highest baudrate handled by all nodes, must be called by the detecting node
+ * @param ll_container sending the negotiation messages
+ * @param node_nbr number of nodes on the network
+ * @param baudrates candidates sorted from the preferred one
+ * @param baudrate_nbr number of candidates
+ * @return the baudrate used by the network at the end of the negotiation
+ ******************************************************************************/
+uint32_t Baud_Negotiate(ll_container_t *ll_container, uint16_t node_nbr, const uint32_t *baudrates, uint8_t baudrate_nbr)
+{
+    if (baud_state != BAUD_IDLE)
+    {
+        return current_baudrate;
+    }
+    for (uint8_t i = 0; i < baudrate_nbr; i++)
+    {
+        if (Baud_TryRate(ll_container, node_nbr, baudrates[i]) == SUCCEED)
+        {
+            break;
+        }
+    }
+    return current_baudrate;
+}
+/******************************************************************************
+ * @brief run a test of a baudrate on all nodes and commit it if all of them received it properly
+ * @param ll_container sending the negotiation messages
+ * @param node_nbr number of nodes on the network
+ * @param rate baudrate to test
+ * @return SUCCEED if the baudrate is committed
+ ******************************************************************************/
+static error_return_t Baud_TryRate(ll_container_t *ll_container, uint16_t node_nbr, uint32_t rate)
+{
+    msg_t msg;
+    baud_test_t test;
+    uint32_t fallback;
+    uint8_t lost = false;
+    error_return_t result = SUCCEED;
+    uint16_t i, j;
+
+    // Ask all nodes (including this one) to switch to the tested baudrate
+    // The window cover the test reports and the commit rounds
+    test.baudrate = rate;
+    test.window_ms = BAUD_TEST_WINDOW_MS + (BAUD_COMMIT_REPEAT + 1) * node_nbr * (BAUD_REPORT_TIMEOUT_US / 1000);
+    test.pattern_nbr = BAUD_PATTERN_NBR;
+    msg.header.target_mode = BROADCAST;
+    msg.header.target = BROADCAST_VAL;
+    msg.header.cmd = BAUDRATE_TEST;
+    msg.header.size = sizeof(baud_test_t);
+    memcpy(msg.data, test.unmap, sizeof(baud_test_t));
+    if (Robus_SendMsg(ll_container, &msg) == FAILED)
+    {
+        return FAILED;
+    }
+    Baud_Wait(BAUD_SETTLE_US);
+    if (baud_state != BAUD_TESTING)
+    {
+        // This node didn't start the test
+        return FAILED;
+    }
+    fallback = previous_baudrate;
+
+    // Send the test patterns
+    msg.header.cmd = BAUDRATE_PATTERN;
+    msg.header.size = BAUD_PATTERN_SIZE;
+    for (i = 0; i < BAUD_PATTERN_NBR; i++)
+    {
+        for (j = 0; j < BAUD_PATTERN_SIZE; j++)
+        {
+            msg.data[j] = Baud_PatternByte(i, j);
+        }
+        Robus_SendMsg(ll_container, &msg);
+        Robus_Loop();
+    }
+
+    // Get the report of each node
+    for (i = 1; (i <= node_nbr) && (result == SUCCEED); i++)
+    {
+        if (Baud_GetReport(ll_container, i) == FAILED)
+        {
+            // This node doesn't reply
+            result = FAILED;
+        }
+        else if ((received_report.baudrate != rate) || (received_report.pattern_nbr != BAUD_PATTERN_NBR) || (received_report.error_nbr != 0))
+        {
+            // This node have trouble at this baudrate
+            result = FAILED;
+        }
+    }
+
+    if (result == SUCCEED)
+    {
+        // Everybody is fine, commit it until all nodes confirm it at the new baudrate
+        msg.header.target_mode = BROADCAST;
+        msg.header.target = BROADCAST_VAL;
+        msg.header.cmd = BAUDRATE_COMMIT;
+        msg.header.size = sizeof(uint32_t);
+        memcpy(msg.data, &rate, sizeof(uint32_t));
+        result = FAILED;
+        for (i = 0; (i < BAUD_COMMIT_REPEAT) && (result == FAILED) && (lost == false); i++)
+        {
+            Robus_SendMsg(ll_container, &msg);
+            Baud_Wait(BAUD_SETTLE_US);
+            result = (baud_state == BAUD_IDLE) ? SUCCEED : FAILED;
+            for (j = 1; (j <= node_nbr) && (result == SUCCEED); j++)
+            {
+                if ((Baud_GetReport(ll_container, j) == FAILED) || (received_report.baudrate != rate))
+                {
+                    // This node doesn't use the new baudrate anymore
+                    lost = true;
+                    result = FAILED;
+                }
+                else if (received_report.committed == false)
+                {
+                    // This node missed the commit, send it again
+                    result = FAILED;
+                }
+            }
+        }
+        if (result == SUCCEED)
+        {
+            return SUCCEED;
+        }
+        if (baud_state == BAUD_IDLE)
+        {
+            // Some nodes kept the new baudrate but not all of them, put everybody back to the previous one
+            msg.header.cmd = SET_BAUDRATE;
+            memcpy(msg.data, &fallback, sizeof(uint32_t));
+            for (i = 0; i < BAUD_COMMIT_REPEAT; i++)
+            {
+                Robus_SendMsg(ll_container, &msg);
+            }
+            Baud_Wait(BAUD_SETTLE_US);
+            Baud_Set(fallback);
+            previous_baudrate = fallback;
+            Baud_Wait(BAUD_SETTLE_US);
+            return FAILED;
+        }
+    }
+    // Don't commit, wait for all nodes to go back to the previous baudrate
+    while (baud_state == BAUD_TESTING)
+    {
+        Robus_Loop();
+    }
+    Baud_Wait(BAUD_SETTLE_US);
+    return FAILED;
+}
+/******************************************************************************
+ * @brief ask the baudrate report of a node and wait for it into received_report
+ * @param ll_container sending the request
+ * @param node_id node to ask
+ * @return FAILED if the node doesn't reply before BAUD_REPORT_TIMEOUT_US
+ ******************************************************************************/
+static error_return_t Baud_GetReport(ll_container_t *ll_container, uint16_t node_id)
+{
+    msg_t msg;
+    deadline_t deadline;
+    report_received = false;
+    msg.header.target_mode = NODEID;
+    msg.header.target = node_id;
+    msg.header.cmd = BAUDRATE_REPORT;
+    msg.header.size = 0;
+    Robus_SendMsg(ll_container, &msg);
+    Timing_SetDeadline(&deadline, BAUD_REPORT_TIMEOUT_US);
+    while ((!report_received) || (received_report.node_id != node_id))
+    {
+        Robus_Loop();
+        if (Timing_IsExpired(&deadline))
+        {
+            return FAILED;
+        }
+    }
+    return SUCCEED;
+}
+/******************************************************************************
+ * @brief switch to a tested baudrate
+ * @param test informations
+ * @return None
+ ******************************************************************************/
+static void Baud_StartTest(baud_test_t *test)
+{
+    if (baud_state == BAUD_IDLE)
+    {
+        previous_baudrate = current_baudrate;
+    }
+    baud_state = BAUD_TESTING;
+    Timing_SetDeadline(&test_deadline, (uint32_t)test->window_ms * 1000);
+    Baud_Set(test->baudrate);
+    memset(test_report.unmap, 0, sizeof(baud_report_t));
+    test_report.baudrate = test->baudrate;
+    test_error_ref = Baud_GetErrorNbr();
+}
+/******************************************************************************
+ * @brief compute a test pattern byte
+ * @param index of the pattern message
+ * @param i byte position into the message
+ * @return the byte value
+ ******************************************************************************/
+static uint8_t Baud_PatternByte(uint16_t index, uint16_t i)
+{
+    if (i == 0)
+    {
+        return (uint8_t)index;
+    }
+    // alternate long runs and fast transitions
+    switch (i & 0x03)
+    {
+    case 0:
+        return 0x55;
+        break;
+    case 1:
+        return 0xAA;
+        break;
+    case 2:
+        return (i & 0x04) ? 0xFF : 0x00;
+        break;
+    default:
+        return (uint8_t)(index * 37 + i);
+        break;
+    }
+}
+/******************************************************************************
+ * @brief get the number of reception errors of this node
+ * @param None
+ * @return errors number
+ ******************************************************************************/
+static uint32_t Baud_GetErrorNbr(void)
+{
+    return (uint32_t)ctx.stats.crc_error_nbr + ctx.stats.framing_error_nbr + ctx.stats.timeout_nbr;
+}
+/******************************************************************************
+ * @brief run Robus_Loop during a time
+ * @param delay in us
+ * @return None
+ ******************************************************************************/
+static void Baud_Wait(uint32_t delay)
+{
+    deadline_t deadline;
+    Timing_SetDeadline(&deadline, delay);
+    while (!Timing_IsExpired(&deadline))
+    {
+        Robus_Loop();
+    }
+}
@@ -0,0 +1,198 @@
+/******************************************************************************
+ * @file crc
+ * @brief Robus CRC computation
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include "crc.h"
+
+#include "luos_hal.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+#if (CRC_HAL == FALSE)
+/*
+ * CRC-16 polynomial 0x0007, MSB first, the same as LuosHAL_ComputeCRC.
+ * crc_table[0] is the classic byte table, crc_table[n] is the CRC of a byte
+ * followed by n null bytes allowing to compute 4 bytes at once (slice by 4).
+ */
+static const uint16_t crc_table[4][256] = {
+    {
+        0x0000, 0x0007, 0x000E, 0x0009, 0x001C, 0x001B, 0x0012, 0x0015,
+        0x0038, 0x003F, 0x0036, 0x0031, 0x0024, 0x0023, 0x002A, 0x002D,
+        0x0070, 0x0077, 0x007E, 0x0079, 0x006C, 0x006B, 0x0062, 0x0065,
+        0x0048, 0x004F, 0x0046, 0x0041, 0x0054, 0x0053, 0x005A, 0x005D,
+        0x00E0, 0x00E7, 0x00EE, 0x00E9, 0x00FC, 0x00FB, 0x00F2, 0x00F5,
+        0x00D8, 0x00DF, 0x00D6, 0x00D1, 0x00C4, 0x00C3, 0x00CA, 0x00CD,
+        0x0090, 0x0097, 0x009E, 0x0099, 0x008C, 0x008B, 0x0082, 0x0085,
+        0x00A8, 0x00AF, 0x00A6, 0x00A1, 0x00B4, 0x00B3, 0x00BA, 0x00BD,
+        0x01C0, 0x01C7, 0x01CE, 0x01C9, 0x01DC, 0x01DB, 0x01D2, 0x01D5,
+        0x01F8, 0x01FF, 0x01F6, 0x01F1, 0x01E4, 0x01E3, 0x01EA, 0x01ED,
+        0x01B0, 0x01B7, 0x01BE, 0x01B9, 0x01AC, 0x01AB, 0x01A2, 0x01A5,
+        0x0188, 0x018F, 0x0186, 0x0181, 0x0194, 0x0193, 0x019A, 0x019D,
+        0x0120, 0x0127, 0x012E, 0x0129, 0x013C, 0x013B, 0x0132, 0x0135,
+        0x0118, 0x011F, 0x0116, 0x0111, 0x0104, 0x0103, 0x010A, 0x010D,
+        0x0150, 0x0157, 0x015E, 0x0159, 0x014C, 0x014B, 0x0142, 0x0145,
+        0x0168, 0x016F, 0x0166, 0x0161, 0x0174, 0x0173, 0x017A, 0x017D,
+        0x0380, 0x0387, 0x038E, 0x0389, 0x039C, 0x039B, 0x0392, 0x0395,
+        0x03B8, 0x03BF, 0x03B6, 0x03B1, 0x03A4, 0x03A3, 0x03AA, 0x03AD,
+        0x03F0, 0x03F7, 0x03FE, 0x03F9, 0x03EC, 0x03EB, 0x03E2, 0x03E5,
+        0x03C8, 0x03CF, 0x03C6, 0x03C1, 0x03D4, 0x03D3, 0x03DA, 0x03DD,
+        0x0360, 0x0367, 0x036E, 0x0369, 0x037C, 0x037B, 0x0372, 0x0375,
+        0x0358, 0x035F, 0x0356, 0x0351, 0x0344, 0x0343, 0x034A, 0x034D,
+        0x0310, 0x0317, 0x031E, 0x0319, 0x030C, 0x030B, 0x0302, 0x0305,
+        0x0328, 0x032F, 0x0326, 0x0321, 0x0334, 0x0333, 0x033A, 0x033D,
+        0x0240, 0x0247, 0x024E, 0x0249, 0x025C, 0x025B, 0x0252, 0x0255,
+        0x0278, 0x027F, 0x0276, 0x0271, 0x0264, 0x0263, 0x026A, 0x026D,
+        0x0230, 0x0237, 0x023E, 0x0239, 0x022C, 0x022B, 0x0222, 0x0225,
+        0x0208, 0x020F, 0x0206, 0x0201, 0x0214, 0x0213, 0x021A, 0x021D,
+        0x02A0, 0x02A7, 0x02AE, 0x02A9, 0x02BC, 0x02BB, 0x02B2, 0x02B5,
+        0x0298, 0x029F, 0x0296, 0x0291, 0x0284, 0x0283, 0x028A, 0x028D,
+        0x02D0, 0x02D7, 0x02DE, 0x02D9, 0x02CC, 0x02CB, 0x02C2, 0x02C5,
+        0x02E8, 0x02EF, 0x02E6, 0x02E1, 0x02F4, 0x02F3, 0x02FA, 0x02FD
+    },
+    {
+        0x0000, 0x0700, 0x0E00, 0x0900, 0x1C00, 0x1B00, 0x1200, 0x1500,
+        0x3800, 0x3F00, 0x3600, 0x3100, 0x2400, 0x2300, 0x2A00, 0x2D00,
+        0x7000, 0x7700, 0x7E00, 0x7900, 0x6C00, 0x6B00, 0x6200, 0x6500,
+        0x4800, 0x4F00, 0x4600, 0x4100, 0x5400, 0x5300, 0x5A00, 0x5D00,
+        0xE000, 0xE700, 0xEE00, 0xE900, 0xFC00, 0xFB00, 0xF200, 0xF500,
+        0xD800, 0xDF00, 0xD600, 0xD100, 0xC400, 0xC300, 0xCA00, 0xCD00,
+        0x9000, 0x9700, 0x9E00, 0x9900, 0x8C00, 0x8B00, 0x8200, 0x8500,
+        0xA800, 0xAF00, 0xA600, 0xA100, 0xB400, 0xB300, 0xBA00, 0xBD00,
+        0xC007, 0xC707, 0xCE07, 0xC907, 0xDC07, 0xDB07, 0xD207, 0xD507,
+        0xF807, 0xFF07, 0xF607, 0xF107, 0xE407, 0xE307, 0xEA07, 0xED07,
+        0xB007, 0xB707, 0xBE07, 0xB907, 0xAC07, 0xAB07, 0xA207, 0xA507,
+        0x8807, 0x8F07, 0x8607, 0x8107, 0x9407, 0x9307, 0x9A07, 0x9D07,
+        0x2007, 0x2707, 0x2E07, 0x2907, 0x3C07, 0x3B07, 0x3207, 0x3507,
+        0x1807, 0x1F07, 0x1607, 0x1107, 0x0407, 0x0307, 0x0A07, 0x0D07,
+        0x5007, 0x5707, 0x5E07, 0x5907, 0x4C07, 0x4B07, 0x4207, 0x4507,
+        0x6807, 0x6F07, 0x6607, 0x6107, 0x7407, 0x7307, 0x7A07, 0x7D07,
+        0x8009, 0x8709, 0x8E09, 0x8909, 0x9C09, 0x9B09, 0x9209, 0x9509,
+        0xB809, 0xBF09, 0xB609, 0xB109, 0xA409, 0xA309, 0xAA09, 0xAD09,
+        0xF009, 0xF709, 0xFE09, 0xF909, 0xEC09, 0xEB09, 0xE209, 0xE509,
+        0xC809, 0xCF09, 0xC609, 0xC109, 0xD409, 0xD309, 0xDA09, 0xDD09,
+        0x6009, 0x6709, 0x6E09, 0x6909, 0x7C09, 0x7B09, 0x7209, 0x7509,
+        0x5809, 0x5F09, 0x5609, 0x5109, 0x4409, 0x4309, 0x4A09, 0x4D09,
+        0x1009, 0x1709, 0x1E09, 0x1909, 0x0C09, 0x0B09, 0x0209, 0x0509,
+        0x2809, 0x2F09, 0x2609, 0x2109, 0x3409, 0x3309, 0x3A09, 0x3D09,
+        0x400E, 0x470E, 0x4E0E, 0x490E, 0x5C0E, 0x5B0E, 0x520E, 0x550E,
+        0x780E, 0x7F0E, 0x760E, 0x710E, 0x640E, 0x630E, 0x6A0E, 0x6D0E,
+        0x300E, 0x370E, 0x3E0E, 0x390E, 0x2C0E, 0x2B0E, 0x220E, 0x250E,
+        0x080E, 0x0F0E, 0x060E, 0x010E, 0x140E, 0x130E, 0x1A0E, 0x1D0E,
+        0xA00E, 0xA70E, 0xAE0E, 0xA90E, 0xBC0E, 0xBB0E, 0xB20E, 0xB50E,
+        0x980E, 0x9F0E, 0x960E, 0x910E, 0x840E, 0x830E, 0x8A0E, 0x8D0E,
+        0xD00E, 0xD70E, 0xDE0E, 0xD90E, 0xCC0E, 0xCB0E, 0xC20E, 0xC50E,
+        0xE80E, 0xEF0E, 0xE60E, 0xE10E, 0xF40E, 0xF30E, 0xFA0E, 0xFD0E
+    },
+    {
+        0x0000, 0x0015, 0x002A, 0x003F, 0x0054, 0x0041, 0x007E, 0x006B,
+        0x00A8, 0x00BD, 0x0082, 0x0097, 0x00FC, 0x00E9, 0x00D6, 0x00C3,
+        0x0150, 0x0145, 0x017A, 0x016F, 0x0104, 0x0111, 0x012E, 0x013B,
+        0x01F8, 0x01ED, 0x01D2, 0x01C7, 0x01AC, 0x01B9, 0x0186, 0x0193,
+        0x02A0, 0x02B5, 0x028A, 0x029F, 0x02F4, 0x02E1, 0x02DE, 0x02CB,
+        0x0208, 0x021D, 0x0222, 0x0237, 0x025C, 0x0249, 0x0276, 0x0263,
+        0x03F0, 0x03E5, 0x03DA, 0x03CF, 0x03A4, 0x03B1, 0x038E, 0x039B,
+        0x0358, 0x034D, 0x0372, 0x0367, 0x030C, 0x0319, 0x0326, 0x0333,
+        0x0540, 0x0555, 0x056A, 0x057F, 0x0514, 0x0501, 0x053E, 0x052B,
+        0x05E8, 0x05FD, 0x05C2, 0x05D7, 0x05BC, 0x05A9, 0x0596, 0x0583,
+        0x0410, 0x0405, 0x043A, 0x042F, 0x0444, 0x0451, 0x046E, 0x047B,
+        0x04B8, 0x04AD, 0x0492, 0x0487, 0x04EC, 0x04F9, 0x04C6, 0x04D3,
+        0x07E0, 0x07F5, 0x07CA, 0x07DF, 0x07B4, 0x07A1, 0x079E, 0x078B,
+        0x0748, 0x075D, 0x0762, 0x0777, 0x071C, 0x0709, 0x0736, 0x0723,
+        0x06B0, 0x06A5, 0x069A, 0x068F, 0x06E4, 0x06F1, 0x06CE, 0x06DB,
+        0x0618, 0x060D, 0x0632, 0x0627, 0x064C, 0x0659, 0x0666, 0x0673,
+        0x0A80, 0x0A95, 0x0AAA, 0x0ABF, 0x0AD4, 0x0AC1, 0x0AFE, 0x0AEB,
+        0x0A28, 0x0A3D, 0x0A02, 0x0A17, 0x0A7C, 0x0A69, 0x0A56, 0x0A43,
+        0x0BD0, 0x0BC5, 0x0BFA, 0x0BEF, 0x0B84, 0x0B91, 0x0BAE, 0x0BBB,
+        0x0B78, 0x0B6D, 0x0B52, 0x0B47, 0x0B2C, 0x0B39, 0x0B06, 0x0B13,
+        0x0820, 0x0835, 0x080A, 0x081F, 0x0874, 0x0861, 0x085E, 0x084B,
+        0x0888, 0x089D, 0x08A2, 0x08B7, 0x08DC, 0x08C9, 0x08F6, 0x08E3,
+        0x0970, 0x0965, 0x095A, 0x094F, 0x0924, 0x0931, 0x090E, 0x091B,
+        0x09D8, 0x09CD, 0x09F2, 0x09E7, 0x098C, 0x0999, 0x09A6, 0x09B3,
+        0x0FC0, 0x0FD5, 0x0FEA, 0x0FFF, 0x0F94, 0x0F81, 0x0FBE, 0x0FAB,
+        0x0F68, 0x0F7D, 0x0F42, 0x0F57, 0x0F3C, 0x0F29, 0x0F16, 0x0F03,
+        0x0E90, 0x0E85, 0x0EBA, 0x0EAF, 0x0EC4, 0x0ED1, 0x0EEE, 0x0EFB,
+        0x0E38, 0x0E2D, 0x0E12, 0x0E07, 0x0E6C, 0x0E79, 0x0E46, 0x0E53,
+        0x0D60, 0x0D75, 0x0D4A, 0x0D5F, 0x0D34, 0x0D21, 0x0D1E, 0x0D0B,
+        0x0DC8, 0x0DDD, 0x0DE2, 0x0DF7, 0x0D9C, 0x0D89, 0x0DB6, 0x0DA3,
+        0x0C30, 0x0C25, 0x0C1A, 0x0C0F, 0x0C64, 0x0C71, 0x0C4E, 0x0C5B,
+        0x0C98, 0x0C8D, 0x0CB2, 0x0CA7, 0x0CCC, 0x0CD9, 0x0CE6, 0x0CF3
+    },
+    {
+        0x0000, 0x1500, 0x2A00, 0x3F00, 0x5400, 0x4100, 0x7E00, 0x6B00,
+        0xA800, 0xBD00, 0x8200, 0x9700, 0xFC00, 0xE900, 0xD600, 0xC300,
+        0x5007, 0x4507, 0x7A07, 0x6F07, 0x0407, 0x1107, 0x2E07, 0x3B07,
+        0xF807, 0xED07, 0xD207, 0xC707, 0xAC07, 0xB907, 0x8607, 0x9307,
+        0xA00E, 0xB50E, 0x8A0E, 0x9F0E, 0xF40E, 0xE10E, 0xDE0E, 0xCB0E,
+        0x080E, 0x1D0E, 0x220E, 0x370E, 0x5C0E, 0x490E, 0x760E, 0x630E,
+        0xF009, 0xE509, 0xDA09, 0xCF09, 0xA409, 0xB109, 0x8E09, 0x9B09,
+        0x5809, 0x4D09, 0x7209, 0x6709, 0x0C09, 0x1909, 0x2609, 0x3309,
+        0x401B, 0x551B, 0x6A1B, 0x7F1B, 0x141B, 0x011B, 0x3E1B, 0x2B1B,
+        0xE81B, 0xFD1B, 0xC21B, 0xD71B, 0xBC1B, 0xA91B, 0x961B, 0x831B,
+        0x101C, 0x051C, 0x3A1C, 0x2F1C, 0x441C, 0x511C, 0x6E1C, 0x7B1C,
+        0xB81C, 0xAD1C, 0x921C, 0x871C, 0xEC1C, 0xF91C, 0xC61C, 0xD31C,
+        0xE015, 0xF515, 0xCA15, 0xDF15, 0xB415, 0xA115, 0x9E15, 0x8B15,
+        0x4815, 0x5D15, 0x6215, 0x7715, 0x1C15, 0x0915, 0x3615, 0x2315,
+        0xB012, 0xA512, 0x9A12, 0x8F12, 0xE412, 0xF112, 0xCE12, 0xDB12,
+        0x1812, 0x0D12, 0x3212, 0x2712, 0x4C12, 0x5912, 0x6612, 0x7312,
+        0x8036, 0x9536, 0xAA36, 0xBF36, 0xD436, 0xC136, 0xFE36, 0xEB36,
+        0x2836, 0x3D36, 0x0236, 0x1736, 0x7C36, 0x6936, 0x5636, 0x4336,
+        0xD031, 0xC531, 0xFA31, 0xEF31, 0x8431, 0x9131, 0xAE31, 0xBB31,
+        0x7831, 0x6D31, 0x5231, 0x4731, 0x2C31, 0x3931, 0x0631, 0x1331,
+        0x2038, 0x3538, 0x0A38, 0x1F38, 0x7438, 0x6138, 0x5E38, 0x4B38,
+        0x8838, 0x9D38, 0xA238, 0xB738, 0xDC38, 0xC938, 0xF638, 0xE338,
+        0x703F, 0x653F, 0x5A3F, 0x4F3F, 0x243F, 0x313F, 0x0E3F, 0x1B3F,
+        0xD83F, 0xCD3F, 0xF23F, 0xE73F, 0x8C3F, 0x993F, 0xA63F, 0xB33F,
+        0xC02D, 0xD52D, 0xEA2D, 0xFF2D, 0x942D, 0x812D, 0xBE2D, 0xAB2D,
+        0x682D, 0x7D2D, 0x422D, 0x572D, 0x3C2D, 0x292D, 0x162D, 0x032D,
+        0x902A, 0x852A, 0xBA2A, 0xAF2A, 0xC42A, 0xD12A, 0xEE2A, 0xFB2A,
+        0x382A, 0x2D2A, 0x122A, 0x072A, 0x6C2A, 0x792A, 0x462A, 0x532A,
+        0x6023, 0x7523, 0x4A23, 0x5F23, 0x3423, 0x2123, 0x1E23, 0x0B23,
+        0xC823, 0xDD23, 0xE223, 0xF723, 0x9C23, 0x8923, 0xB623, 0xA323,
+        0x3024, 0x2524, 0x1A24, 0x0F24, 0x6424, 0x7124, 0x4E24, 0x5B24,
+        0x9824, 0x8D24, 0xB224, 0xA724, 0xCC24, 0xD924, 0xE624, 0xF324
+    }
+};
+#endif
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief Continue a CRC computation with a block of bytes
+ * @param crc : current CRC value, CRC_INIT_VAL to start a new computation
+ * @param buf : bytes to add to the CRC
+ * @param len : number of bytes
+ * @return the new CRC value
+ ******************************************************************************/
+uint16_t Crc_Update(uint16_t crc, const uint8_t *buf, uint16_t len)
+{
+#if (CRC_HAL == TRUE)
+    // Let the HAL compute it, allowing to use a CRC hardware unit
+    while (len--)
+    {
+        LuosHAL_ComputeCRC((uint8_t *)buf++, (uint8_t *)&crc);
+    }
+#else
+    uint16_t tmp;
+    while (len >= 4)
+    {
+        tmp = crc ^ (((uint16_t)buf[0] << 8) | buf[1]);
+        crc = crc_table[3][tmp >> 8] ^ crc_table[2][tmp & 0xFF] ^ crc_table[1][buf[2]] ^ crc_table[0][buf[3]];
+        buf += 4;
+        len -= 4;
+    }
+    while (len--)
+    {
+        crc = (uint16_t)(crc << 8) ^ crc_table[0][(crc >> 8) ^ *buf++];
+    }
+#endif
+    return crc;
+}
@@ -24,19 +24,53 @@
  *
  *  - Event A : This event is called by IT and represent the end of reception of
  *              the header. In this event we get the size of the complete message
- *              so we can check if we are at the end of the msg_buffer and report
- *              writing pointer to the begin of msg_buffer
+ *              and reserve all its space. Headers are received where a header
+ *              fit, if the complete message don't fit before the end of
+ *              msg_buffer its header is moved to the start of msg_buffer.
  *  - Event B : This event is called by IT and represent the end of a good message.
  *              In this event we have to save the message into a msg_tasks
- *              called "Msg B" on this example. we have to check if there is validated
- *              tasks at this space in memory and clear the memory space use by
- *              msg_tasks or Luos_tasks. Also we have to prepare the reception of
+ *              called "Msg B" on this example and prepare the reception of
  *              the next header.
  *  - Event C : This event represent robus_loop and it is executed outside of IT.
  *              This event pull msg_tasks tasks and interpret all messages to
  *              create one or more Luos_tasks.
  *  - Task D  : This is all msg trait by Luos Library interpret in Luos_loop. Msg can be
  *              for Luos Library or for container. this is executed outside of IT.
+ *              Luos_tasks are chained in arrival order for Luos_loop and into
+ *              a FIFO per ll_container allowing to pull a container message
+ *              without scanning or sliding the others.
+ *
+ * IT is the only producer of msg_buffer and msg_tasks, and loops are the only
+ * consumer, so they share them without masking IRQ :
+ *  - Each message have a virtual position, growing with msg_buffer writing
+ *    without wrapping. IT publish the virtual end of the space it can write
+ *    (write_vend) before writing it, a message is overwritten when it is more
+ *    than MSG_BUFFER_SIZE behind it. Loops check it before using a message and
+ *    IT never have to clean anything into msg_tasks or Luos_tasks.
+ *  - msg_tasks slots are published by IT with a sequence number. Loops publish
+ *    the number of msg_tasks consumed, and detect slots overwritten by IT.
+ *  - Loops publish the virtual position of the oldest message they still need
+ *    (release_vpos) allowing IT to refuse messages instead of overwriting it.
+ *  - Messages pinned by containers are never overwritten, whatever the overflow
+ *    policy is. Loops publish the virtual position of the oldest one
+ *    (pinned_vpos) and IT drop new messages instead of overwriting it.
+ *
+ * A localhost message can also be reserved directly into msg_buffer at the
+ * place of the next reception. Its msg_tasks slot is taken at reservation to
+ * keep msg_buffer order, and Robus_Loop wait for it to be commited. While a
+ * message is reserved reception can't write over it, if msg_buffer is full
+ * up to the reserved message incoming messages are dropped. Localhost messages
+ * are a second producer, so they are the only ones to mask IRQ.
+ *
+ * When there is no more space for a new message the overflow policy select
+ * between removing the oldest pending messages (DROP_OLDEST), dropping the new
+ * one (DROP_NEWEST), or dropping it with a NAK and stop interpreting messages
+ * while luos_tasks is full (BACKPRESSURE) allowing senders to retry later.
+ *
+ * Messages have a priority given by their cmd or by the container they target.
+ * Each priority have its own msg_tasks lane, and high priority messages have
+ * reserved luos_tasks and msg_buffer space. Loops interpret and deliver high
+ * priority messages first.
  *
  * After all of it Luos_tasks are ready to be managed by luos_loop execution.
  ******************************************************************************/
@@ -47,44 +81,171 @@
 #include "msg_alloc.h"
 #include "luos_hal.h"
 #include "luos_utils.h"
+#include "context.h"
+#include "target.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+#define NO_LUOS_TASK 0xFFFF
+
+#define MSGALLOC_COUNT_DROP(counter) \
+    if (counter < 0xFFFF)            \
+    {                                \
+        counter++;                   \
+    }
+
+#if (MAX_CONTAINER_NUMBER > 32)
+#error "Shared luos tasks can't manage more than 32 containers"
+#endif
+
+/******************************************************************************
+ * @struct msg_task_t
+ * @brief Message ready to be interpreted by Robus_Loop.
+ ******************************************************************************/
+typedef struct
+{
+    msg_t *msg_pt; /*!< Start pointer of the msg on msg_buffer, NULL for a canceled reservation. */
+    uint32_t vpos; /*!< Virtual position of the msg. */
+    uint16_t seq;  /*!< Number of the msg_tasks, written last to publish the slot. */
+} msg_task_t;
+
+/******************************************************************************
+ * @struct pinned_msg_t
+ * @brief Message kept valid into msg_buffer until it is unpinned.
+ ******************************************************************************/
+typedef struct
+{
+    msg_t *msg_pt;   /*!< Start pointer of the msg on msg_buffer, NULL for a free slot. */
+    uint32_t vpos;   /*!< Virtual position of the msg. */
+    uint8_t ref_nbr; /*!< Number of pins on this msg. */
+} pinned_msg_t;
+
+/******************************************************************************
+ * @struct batch_pin_t
+ * @brief Messages of a ll_container batch kept valid into msg_buffer until the batch is released.
+ ******************************************************************************/
+typedef struct
+{
+    msg_t *first_msg;    /*!< Oldest msg of the batch on msg_buffer, NULL if there is no pending batch. */
+    msg_t *last_msg;     /*!< Newest msg of the batch on msg_buffer. */
+    uint32_t first_vpos; /*!< Virtual position of the oldest msg. */
+    uint32_t last_vpos;  /*!< Virtual position of the newest msg. */
+} batch_pin_t;
 
 /******************************************************************************
  * @struct luos_task_t
  * @brief Message allocator loger structure.
- * 
+ *
  * This structure is used to link modules and messages into the allocator.
- * 
+ * Each task is chained twice : into the global arrival order used by Luos_Loop
+ * and into the FIFO of the concerned ll_container.
+ * A message concerning multiple ll_containers (BROADCAST, NODEID) use only one
+ * shared task chained into the shared tasks list instead of a ll_container FIFO.
+ * This shared task keep a mask of the ll_containers still to consume it and is
+ * released when the last one pull it. Each ll_container keep the oldest shared
+ * task it didn't consume yet, so its oldest message is found without scanning.
+ * Tasks of a ll_container FIFO are limited by its quotas, shared tasks are not.
+ *
  ******************************************************************************/
 typedef struct __attribute__((__packed__))
 {
     msg_t *msg_pt;                   /*!< Start pointer of the msg on msg_buffer. */
-    ll_container_t *ll_container_pt; /*!< Pointer to the concerned ll_container. */
+    uint32_t vpos;                   /*!< Virtual position of the msg. */
+    ll_container_t *ll_container_pt; /*!< Pointer to the concerned ll_container, NULL for a shared task. */
+    container_mask_t container_mask; /*!< ll_containers still to consume a shared task. */
+    uint16_t arrival;                /*!< Arrival date used to order ll_container FIFO and shared tasks. */
+    uint16_t byte_nbr;               /*!< Size of the msg into msg_buffer. */
+    uint8_t priority;                /*!< Priority of the msg. */
+    uint16_t prev;                   /*!< Previous luos_tasks id in arrival order. */
+    uint16_t next;                   /*!< Next luos_tasks id in arrival order (or next free luos_tasks id). */
+    uint16_t container_prev;         /*!< Previous luos_tasks id of the same ll_container (or of the shared tasks list). */
+    uint16_t container_next;         /*!< Next luos_tasks id of the same ll_container (or of the shared tasks list). */
 } luos_task_t;
+
+/******************************************************************************
+ * @struct luos_task_fifo_t
+ * @brief Oldest and newest luos_tasks id of a chained list of tasks.
+ ******************************************************************************/
+typedef struct
+{
+    uint16_t first; /*!< Oldest luos_tasks id. */
+    uint16_t last;  /*!< Newest luos_tasks id. */
+} luos_task_fifo_t;
+
+/******************************************************************************
+ * @struct luos_task_cursor_t
+ * @brief Last luos_tasks slot found at a position of the interpretation order.
+ *
+ * Luos_Loop look at the same position several times for each message, the
+ * cursor avoid to scan the luos_tasks again for each of these lookups.
+ *
+ ******************************************************************************/
+typedef struct
+{
+    uint16_t position;        /*!< Position in the interpretation order. */
+    uint16_t task_id;         /*!< luos_tasks id at this position. */
+    uint16_t container_index; /*!< Index of the ll_container concerned at this position. */
+    uint8_t priority;         /*!< Priority of the task at this position. */
+    uint8_t valid;            /*!< false when luos_tasks changed since the cursor was set. */
+} luos_task_cursor_t;
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 memory_stats_t *mem_stat = NULL;
+volatile overflow_policy_t overflow_policy = MSG_OVERFLOW_POLICY; /*!< Behavior of the allocator when there is no more space for a new message. */
+volatile uint8_t high_priority_cmd_nb = ROBUS_PROTOCOL_NB;         /*!< Messages with a cmd lower than this one have a high priority. */
 
-// msg buffering
-volatile uint8_t msg_buffer[MSG_BUFFER_SIZE]; /*!< Memory space used to save and alloc messages. */
-volatile msg_t *current_msg;                  /*!< current work in progress msg pointer. */
-volatile uint8_t *data_ptr;                   /*!< Pointer to the next data able to be writen into msgbuffer. */
+// msg buffering (written by IT)
+volatile uint8_t msg_buffer[MSG_BUFFER_SIZE];   /*!< Memory space used to save and alloc messages. */
+volatile msg_t *current_msg;                    /*!< current work in progress msg pointer. */
+volatile uint8_t *data_ptr;                     /*!< Pointer to the next data able to be writen into msgbuffer. */
+volatile uint8_t drop_buffer[sizeof(header_t)]; /*!< Memory space used to receive headers of messages dropped because msg_buffer is locked. */
+volatile uint8_t *resume_ptr;                   /*!< Place of the next message to receive when msg_buffer will be unlocked. */
+volatile uint32_t current_vpos;                 /*!< Virtual position of current_msg (or of resume_ptr if msg_buffer is locked). */
+volatile uint32_t write_vend;                   /*!< Virtual end of the space IT can write, published before writing. */
 
-// Allocator task stack
-volatile header_t *copy_task_pointer = NULL; /*!< This pointer is used to perform a header copy from the end of the msg_buffer to the begin of the msg_buffer. If this pointer if different than NULL there is a copy to make. */
+// msg buffering (written by loops)
+volatile uint32_t release_vpos; /*!< Virtual position of the oldest message still needed by loops. */
 
-// msg interpretation task stack
-volatile msg_t *msg_tasks[MAX_MSG_NB]; /*!< ready message table. */
-volatile uint16_t msg_tasks_stack_id;  /*!< last writen msg_tasks id. */
+// pinned messages (written by loops)
+volatile pinned_msg_t pinned_msgs[MAX_PINNED_MSG]; /*!< Messages pinned by containers. */
+volatile batch_pin_t batch_pins[MAX_CONTAINER_NUMBER]; /*!< Pending batch of each ll_container. */
+volatile uint8_t pinned_msg_nbr;                   /*!< Number of pinned messages and batches. */
+volatile uint32_t pinned_vpos;                     /*!< Virtual position of the oldest pinned message. */
 
-// Luos task stack
+// localhost reservation
+volatile msg_t *reserved_msg = NULL; /*!< Message reserved into msg_buffer and not commited yet. */
+volatile uint8_t *reserved_end;      /*!< End of the reserved message memory space. */
+volatile uint32_t reserved_vpos;     /*!< Virtual position of the reserved message. */
+volatile uint16_t reserved_task_id;  /*!< msg_tasks id of the reserved message (into the NORMAL_PRIORITY lane). */
+volatile uint16_t reserved_task_seq; /*!< msg_tasks number of the reserved message. */
+
+// msg interpretation task stack, one lane per priority
+volatile msg_task_t msg_tasks[PRIORITY_NB][MAX_MSG_NB]; /*!< ready message ring queues. */
+volatile uint16_t msg_tasks_tail[PRIORITY_NB];          /*!< next msg_tasks id to be writen (written by IT). */
+volatile uint16_t msg_tasks_in[PRIORITY_NB];            /*!< number of msg_tasks writen (written by IT). */
+volatile uint16_t msg_tasks_head[PRIORITY_NB];          /*!< oldest msg_tasks id, the next one to be pulled (written by loops). */
+volatile uint16_t msg_tasks_out[PRIORITY_NB];           /*!< number of msg_tasks pulled (written by loops). */
+volatile uint32_t interpreted_vpos;                     /*!< Virtual position of the last msg pulled from msg_tasks. */
+volatile uint8_t interpreting;                          /*!< true while the last msg pulled from msg_tasks is interpreted. */
+
+// Luos task stack (only used by loops)
 volatile msg_t *used_msg = NULL;
-volatile luos_task_t luos_tasks[MAX_MSG_NB]; /*!< Message allocation table. */
-volatile uint16_t luos_tasks_stack_id;       /*!< last writen luos_tasks id. */
+volatile uint32_t used_vpos;                                     /*!< Virtual position of used_msg. */
+volatile luos_task_t luos_tasks[MAX_MSG_NB];                     /*!< Message allocation table. */
+volatile uint16_t luos_tasks_stack_id;                           /*!< number of allocated luos_tasks. */
+volatile uint16_t luos_tasks_free;                               /*!< first free luos_tasks id. */
+volatile luos_task_fifo_t luos_tasks_order;                      /*!< luos_tasks in arrival order. */
+volatile luos_task_fifo_t container_tasks[MAX_CONTAINER_NUMBER]; /*!< luos_tasks of each ll_container in arrival order. */
+volatile luos_task_fifo_t shared_tasks;                          /*!< shared luos_tasks in arrival order. */
+volatile uint16_t shared_tasks_first[MAX_CONTAINER_NUMBER];      /*!< oldest shared luos_tasks each ll_container didn't consume yet. */
+volatile uint16_t container_task_nbr[MAX_CONTAINER_NUMBER];      /*!< number of luos_tasks into each ll_container FIFO. */
+volatile uint16_t container_byte_nbr[MAX_CONTAINER_NUMBER];      /*!< size of the messages into each ll_container FIFO. */
+volatile uint16_t high_task_nbr;                                 /*!< number of HIGH_PRIORITY luos_tasks. */
+volatile uint16_t luos_tasks_arrival;                            /*!< arrival date of the next luos_tasks. */
+volatile uint16_t luos_tasks_delivery_nbr;                       /*!< number of messages still to be consumed by ll_containers. */
+luos_task_cursor_t luos_tasks_cursor;                            /*!< last luos_tasks found by position. */
 
 /*******************************************************************************
  * Functions
@@ -92,15 +253,43 @@ volatile uint16_t luos_tasks_stack_id;       /*!< last writen luos_tasks id. */
 
 // msg buffering
 static inline error_return_t MsgAlloc_DoWeHaveSpace(void *to);
+static inline uint8_t MsgAlloc_GetPriority(volatile header_t *header);
+static inline uint8_t MsgAlloc_IsTaskFull(uint8_t priority);
+static inline void MsgAlloc_StoreMsg(uint8_t priority);
+static inline uint32_t MsgAlloc_GetVPos(volatile uint8_t *position);
+static inline void MsgAlloc_SetWriteEnd(uint32_t vend);
+static inline error_return_t MsgAlloc_RefuseMsg(uint8_t task_full);
+static inline uint8_t MsgAlloc_IsLocked(uint32_t vpos, uint16_t size);
+static inline uint8_t MsgAlloc_IsHighPrioritySpace(uint8_t priority, uint32_t vpos, uint16_t size);
+static inline void MsgAlloc_WrapMsg(volatile uint8_t **position, uint32_t *vpos, uint16_t full_size);
+static inline void MsgAlloc_PrepareHeader(volatile uint8_t *position);
+static inline void MsgAlloc_PrepareNextMsg(void);
+static inline void MsgAlloc_Unlock(void);
 
 // Allocator task stack
-static inline error_return_t MsgAlloc_ClearMsgSpace(void *from, void *to);
+static inline uint8_t MsgAlloc_IsOverwritten(uint32_t vpos);
+static inline void MsgAlloc_UpdateRelease(void);
+static inline void MsgAlloc_ClearOverwrittenLuosTasks(void);
+static inline void MsgAlloc_UpdatePin(void);
+static inline error_return_t MsgAlloc_Pin(msg_t *msg, uint32_t vpos);
+static inline uint8_t MsgAlloc_IsInBatch(volatile batch_pin_t *batch, msg_t *msg);
+static inline error_return_t MsgAlloc_PinBatch(uint16_t container_index, msg_t *msg, uint32_t vpos);
 
 // msg interpretation task stack
-static inline void MsgAlloc_ClearMsgTask(void);
+static inline uint16_t MsgAlloc_NextMsgTaskId(uint16_t msg_task_id);
 
 // Luos task stack
+static inline uint16_t MsgAlloc_GetContainerIndex(ll_container_t *ll_container);
+static inline uint16_t MsgAlloc_CountContainers(container_mask_t container_mask);
 static inline void MsgAlloc_ClearLuosTask(uint16_t luos_task_id);
+static inline void MsgAlloc_CountContainerDrop(uint16_t container_index);
+static inline void MsgAlloc_DropLuosTask(uint16_t luos_task_id);
+static inline uint16_t MsgAlloc_FreeLuosTasks(ll_container_t *ll_container, uint8_t priority);
+static inline uint16_t MsgAlloc_FindEvictableLuosTask(ll_container_t *ll_container, uint8_t priority);
+static inline uint16_t MsgAlloc_NewLuosTask(msg_t *concerned_msg, ll_container_t *ll_container);
+static inline void MsgAlloc_ConsumeLuosTask(uint16_t luos_task_id, uint16_t container_index);
+static inline error_return_t MsgAlloc_NextLuosTask(luos_task_cursor_t *cursor);
+static inline uint16_t MsgAlloc_FindLuosTask(uint16_t luos_task_position, uint16_t *container_index);
 
 /*******************************************************************************
  * Functions --> generic
@@ -116,12 +305,49 @@ void MsgAlloc_Init(memory_stats_t *memory_stats)
     //******** Init global vars pointers **********
     current_msg = (msg_t *)&msg_buffer[0];
     data_ptr = (uint8_t *)&msg_buffer[0];
-    msg_tasks_stack_id = 0;
+    current_vpos = 0;
+    write_vend = sizeof(header_t) + 2;
+    release_vpos = 0;
+    for (uint16_t i = 0; i < PRIORITY_NB; i++)
+    {
+        msg_tasks_tail[i] = 0;
+        msg_tasks_in[i] = 0;
+        msg_tasks_head[i] = 0;
+        msg_tasks_out[i] = 0;
+    }
+    interpreted_vpos = 0;
+    interpreting = false;
     memset((void *)msg_tasks, 0, sizeof(msg_tasks));
     luos_tasks_stack_id = 0;
     memset((void *)luos_tasks, 0, sizeof(luos_tasks));
-    copy_task_pointer = NULL;
+    // Chain all luos_tasks into the free list
+    for (uint16_t i = 0; i < MAX_MSG_NB; i++)
+    {
+        luos_tasks[i].next = i + 1;
+    }
+    luos_tasks[MAX_MSG_NB - 1].next = NO_LUOS_TASK;
+    luos_tasks_free = 0;
+    luos_tasks_order.first = NO_LUOS_TASK;
+    luos_tasks_order.last = NO_LUOS_TASK;
+    for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+    {
+        container_tasks[i].first = NO_LUOS_TASK;
+        container_tasks[i].last = NO_LUOS_TASK;
+        container_task_nbr[i] = 0;
+        container_byte_nbr[i] = 0;
+        shared_tasks_first[i] = NO_LUOS_TASK;
+    }
+    shared_tasks.first = NO_LUOS_TASK;
+    shared_tasks.last = NO_LUOS_TASK;
+    luos_tasks_arrival = 0;
+    luos_tasks_delivery_nbr = 0;
+    high_task_nbr = 0;
+    luos_tasks_cursor.valid = false;
+    reserved_msg = NULL;
     used_msg = NULL;
+    memset((void *)pinned_msgs, 0, sizeof(pinned_msgs));
+    memset((void *)batch_pins, 0, sizeof(batch_pins));
+    pinned_msg_nbr = 0;
     if (memory_stats != NULL)
     {
         mem_stat = memory_stats;
@@ -136,21 +362,46 @@ void MsgAlloc_loop(void)
 {
     // Compute memory stats for msg task memory usage
     uint8_t stat = 0;
+    uint16_t msg_tasks_nbr = 0;
+    for (uint16_t i = 0; i < PRIORITY_NB; i++)
+    {
+        uint16_t lane_nbr = (uint16_t)(msg_tasks_in[i] - msg_tasks_out[i]);
+        if (lane_nbr > msg_tasks_nbr)
+        {
+            msg_tasks_nbr = lane_nbr;
+        }
+    }
+    if (msg_tasks_nbr > MAX_MSG_NB)
+    {
+        msg_tasks_nbr = MAX_MSG_NB;
+    }
     // Compute memory stats for msg task memory usage
-    stat = (uint8_t)(((uint32_t)msg_tasks_stack_id * 100) / (MAX_MSG_NB));
+    stat = (uint8_t)(((uint32_t)msg_tasks_nbr * 100) / (MAX_MSG_NB));
     if (stat > mem_stat->msg_stack_ratio)
     {
         mem_stat->msg_stack_ratio = stat;
     }
-    // Check if we have to make a header copy from the end to the begin of msg_buffer.
-    if (copy_task_pointer != NULL)
-    {
-        // copy_task_pointer point to a header to copy at the begin of msg_buffer
-        // Copy the header at the begining of msg_buffer
-        memcpy((void *)&msg_buffer[0], (void *)copy_task_pointer, sizeof(header_t));
-        // reset copy_task_pointer status
-        copy_task_pointer = NULL;
-    }
+    // Remove the oldest luos_tasks if their messages have been overwritten
+    MsgAlloc_ClearOverwrittenLuosTasks();
+    MsgAlloc_UpdateRelease();
+}
+/******************************************************************************
+ * @brief select the behavior of the allocator when there is no more space for a new message
+ * @param policy : DROP_OLDEST, DROP_NEWEST or BACKPRESSURE
+ * @return None
+ ******************************************************************************/
+void MsgAlloc_SetOverflowPolicy(overflow_policy_t policy)
+{
+    overflow_policy = policy;
+}
+/******************************************************************************
+ * @brief select the cmd having a high priority
+ * @param cmd_nb : messages with a cmd lower than this one have a high priority, as the Robus protocol extensions
+ * @return None
+ ******************************************************************************/
+void MsgAlloc_SetHighPriorityCmdNb(uint8_t cmd_nb)
+{
+    high_priority_cmd_nb = cmd_nb;
 }
 
 /*******************************************************************************
@@ -172,103 +423,310 @@ static inline error_return_t MsgAlloc_DoWeHaveSpace(void *to)
     }
     return SUCCEED;
 }
+/******************************************************************************
+ * @brief get the priority of a received message
+ * @param header : header of the message
+ * @return HIGH_PRIORITY for protocol cmd or messages targeting a HIGH_PRIORITY container
+ ******************************************************************************/
+static inline uint8_t MsgAlloc_GetPriority(volatile header_t *header)
+{
+    if ((header->cmd < high_priority_cmd_nb) || (header->cmd >= ROBUS_EXTENSION_CMD))
+    {
+        return HIGH_PRIORITY;
+    }
+    if ((header->target_mode == ID) || (header->target_mode == IDACK))
+    {
+        ll_container_t *ll_container = Trgt_GetContainerFromId(header->target);
+        if (ll_container != NULL)
+        {
+            return ll_container->priority;
+        }
+    }
+    return NORMAL_PRIORITY;
+}
+/******************************************************************************
+ * @brief check if a msg_tasks lane is full
+ * @param priority : priority of the lane
+ * @return true if there is no more space on this lane
+ ******************************************************************************/
+static inline uint8_t MsgAlloc_IsTaskFull(uint8_t priority)
+{
+    return ((uint16_t)(msg_tasks_in[priority] - msg_tasks_out[priority]) >= MAX_MSG_NB);
+}
+/******************************************************************************
+ * @brief compute the virtual position of a place following the current message
+ * @warning This function have to be called from IRQ or with IRQ disabled.
+ * @param position : place into msg_buffer
+ * @return virtual position
+ ******************************************************************************/
+static inline uint32_t MsgAlloc_GetVPos(volatile uint8_t *position)
+{
+    volatile uint8_t *current_position = (uint8_t *)current_msg;
+    if (current_msg == (volatile msg_t *)&drop_buffer[0])
+    {
+        current_position = resume_ptr;
+    }
+    if (position >= current_position)
+    {
+        return current_vpos + (uint32_t)(position - current_position);
+    }
+    // position is after a wrap of msg_buffer
+    return current_vpos + (uint32_t)(&msg_buffer[MSG_BUFFER_SIZE] - current_position) + (uint32_t)(position - &msg_buffer[0]);
+}
+/******************************************************************************
+ * @brief publish the virtual end of the space we will write
+ * @warning This function have to be called from IRQ or with IRQ disabled.
+ * @param vend : virtual end of the space
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_SetWriteEnd(uint32_t vend)
+{
+    if ((int32_t)(vend - write_vend) > 0)
+    {
+        write_vend = vend;
+    }
+}
+/******************************************************************************
+ * @brief check if a memory space overlap a message that can't be overwritten
+ * @param vpos : virtual position of the memory space
+ * @param size : size of the memory space
+ * @return true if this space is locked
+ ******************************************************************************/
+static inline uint8_t MsgAlloc_IsLocked(uint32_t vpos, uint16_t size)
+{
+    if ((reserved_msg != NULL) && ((int32_t)(vpos + size - reserved_vpos) > (int32_t)(MSG_BUFFER_SIZE)))
+    {
+        // the reserved message can't be overwritten
+        return true;
+    }
+    if ((pinned_msg_nbr > 0) && ((int32_t)(vpos + size - pinned_vpos) > (int32_t)(MSG_BUFFER_SIZE)))
+    {
+        // pinned messages can't be overwritten
+        return true;
+    }
+    if ((overflow_policy != DROP_OLDEST) && ((int32_t)(vpos + size - release_vpos) > (int32_t)(MSG_BUFFER_SIZE)))
+    {
+        // pending messages can't be overwritten
+        return true;
+    }
+    return false;
+}
+/******************************************************************************
+ * @brief check if a memory space use the end of msg_buffer kept for high priority messages
+ * @param priority : priority of the message
+ * @param vpos : virtual position of the memory space
+ * @param size : size of the memory space
+ * @return true if a message with this priority can't use this space
+ ******************************************************************************/
+static inline uint8_t MsgAlloc_IsHighPrioritySpace(uint8_t priority, uint32_t vpos, uint16_t size)
+{
+    return ((priority == NORMAL_PRIORITY) && (overflow_policy != DROP_OLDEST) && ((int32_t)(vpos + size + HIGH_PRIORITY_BUFFER_SIZE - release_vpos) > (int32_t)(MSG_BUFFER_SIZE)));
+}
+/******************************************************************************
+ * @brief count a received message that can't be saved
+ * @param task_full : true if the message is dropped because msg_tasks is full, false if msg_buffer is full
+ * @return FAILED
+ ******************************************************************************/
+static inline error_return_t MsgAlloc_RefuseMsg(uint8_t task_full)
+{
+    if ((current_msg->header.target_mode == IDACK) || (current_msg->header.target_mode == NODEIDACK))
+    {
+        // This message will be NAK by the reception, the sender will retry it
+        MSGALLOC_COUNT_DROP(mem_stat->nak_number);
+    }
+    else if (task_full == true)
+    {
+        MSGALLOC_COUNT_DROP(mem_stat->task_full_drop);
+    }
+    else
+    {
+        MSGALLOC_COUNT_DROP(mem_stat->buffer_full_drop);
+    }
+    return FAILED;
+}
+/******************************************************************************
+ * @brief move a message place to the start of msg_buffer if the message don't fit before its end
+ * @param position : place of the message into msg_buffer, updated if it move
+ * @param vpos : virtual position of the message, updated if it move
+ * @param full_size : size of the message
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_WrapMsg(volatile uint8_t **position, uint32_t *vpos, uint16_t full_size)
+{
+    if (MsgAlloc_DoWeHaveSpace((void *)(*position + full_size)) == FAILED)
+    {
+        // The end of msg_buffer is skipped
+        *vpos += (uint32_t)(&msg_buffer[MSG_BUFFER_SIZE] - *position);
+        *position = &msg_buffer[0];
+    }
+}
+/******************************************************************************
+ * @brief prepare the reception of the next message header
+ * @warning This function have to be called from IRQ or with IRQ disabled.
+ * @param position : place of the next message into msg_buffer
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_PrepareHeader(volatile uint8_t *position)
+{
+    uint32_t vpos = MsgAlloc_GetVPos(position);
+    // The size of the message is unknown yet, only the header have to fit here.
+    // MsgAlloc_ValidHeader move it to the start of msg_buffer if the message don't fit.
+    MsgAlloc_WrapMsg(&position, &vpos, sizeof(header_t) + 2);
+    current_vpos = vpos;
+    if (MsgAlloc_IsLocked(vpos, sizeof(header_t) + 2))
+    {
+        // msg_buffer is full up to a locked message, receive next headers into drop_buffer until it is unlocked
+        resume_ptr = position;
+        current_msg = (volatile msg_t *)&drop_buffer[0];
+        data_ptr = &drop_buffer[0];
+        return;
+    }
+    // publish the space of the header before writing it
+    MsgAlloc_SetWriteEnd(vpos + sizeof(header_t) + 2);
+    // update the current_msg
+    current_msg = (volatile msg_t *)position;
+    data_ptr = position;
+}
+/******************************************************************************
+ * @brief restart the reception into msg_buffer if it was locked and no message is on reception
+ * @warning This function have to be called from IRQ or with IRQ disabled.
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_Unlock(void)
+{
+    if ((current_msg == (volatile msg_t *)&drop_buffer[0]) && (data_ptr == &drop_buffer[0]))
+    {
+        MsgAlloc_PrepareHeader(resume_ptr);
+    }
+}
 /******************************************************************************
  * @brief Invalid the current message header by removing it (data will be ignored).
+ * @warning This function have to be called from IRQ or with IRQ disabled.
  * @param None
  * @return None
  ******************************************************************************/
 void MsgAlloc_InvalidMsg(void)
 {
     //******** Remove the header by reseting data_ptr *********
-    //clean the memory zone
-    MsgAlloc_ClearMsgSpace((void *)current_msg, (void *)(data_ptr));
     data_ptr = (uint8_t *)current_msg;
-    if (current_msg == (volatile msg_t *)&msg_buffer[0])
-    {
-        copy_task_pointer = NULL;
-    }
+    // if msg_buffer was locked, check if we can receive into it again
+    MsgAlloc_Unlock();
 }
 /******************************************************************************
  * @brief Valid the current message header by preparing the allocator to get the message data
  * @param valid : is the header valid or not
  * @param data_size : size of the data to receive
- * @return None
+ * @return error_return_t : FAILED if the message can't be received and have to be dropped
  ******************************************************************************/
-void MsgAlloc_ValidHeader(uint8_t valid, uint16_t data_size)
+error_return_t MsgAlloc_ValidHeader(uint8_t valid, uint16_t data_size)
 {
     //******** Prepare the allocator to get data  *********
-    // Save the concerned module pointer into the concerned module pointer stack
     if (valid == true)
     {
-        if (MsgAlloc_DoWeHaveSpace((void *)(&current_msg->data[data_size + 2])) == FAILED)
+        volatile uint8_t *position = (uint8_t *)current_msg;
+        uint32_t vpos = current_vpos;
+        uint16_t full_size = sizeof(header_t) + data_size + 2;
+        uint8_t priority = MsgAlloc_GetPriority(&current_msg->header);
+        if (current_msg == (volatile msg_t *)&drop_buffer[0])
         {
-            // We are at the end of msg_buffer, we need to move the current space to the begin of msg_buffer
-            // Create a task to copy the header at the begining of msg_buffer
-            copy_task_pointer = (header_t *)&current_msg->header;
-            // Move current_msg to msg_buffer
-            current_msg = (volatile msg_t *)&msg_buffer[0];
-            // move data_ptr after the new location of the header
-            data_ptr = &msg_buffer[sizeof(header_t)];
+            // msg_buffer was locked, try to receive this message at the place it was waiting for
+            position = resume_ptr;
         }
-        // check if there is a msg traitement pending
-        if (((uint32_t)used_msg >= (uint32_t)current_msg) && ((uint32_t)used_msg <= (uint32_t)(&current_msg->data[data_size + 2])))
+        // Now the size is known, wrap if this message don't fit before the end of msg_buffer
+        MsgAlloc_WrapMsg(&position, &vpos, full_size);
+        if ((overflow_policy != DROP_OLDEST) && MsgAlloc_IsTaskFull(priority))
         {
-            used_msg = NULL;
-            // This message is in the space we want to use, clear the task
-            if (mem_stat->msg_drop_number < 0xFF)
-            {
-                mem_stat->msg_drop_number++;
-            }
+            // There is no more space on the msg_tasks, drop this message
+            data_ptr = (uint8_t *)current_msg;
+            return MsgAlloc_RefuseMsg(true);
         }
+        if (MsgAlloc_IsHighPrioritySpace(priority, vpos, full_size))
+        {
+            // The remaining space is reserved to high priority messages, drop this message
+            data_ptr = (uint8_t *)current_msg;
+            return MsgAlloc_RefuseMsg(false);
+        }
+        if (MsgAlloc_IsLocked(vpos, full_size))
+        {
+            // This message would overwrite a locked message, drop it
+            data_ptr = (uint8_t *)current_msg;
+            return MsgAlloc_RefuseMsg(false);
+        }
+        // publish the space of the message before writing it
+        MsgAlloc_SetWriteEnd(vpos + full_size);
+        if (position != (uint8_t *)current_msg)
+        {
+            // msg_buffer is unlocked or the message wrapped, move the header to its place
+            memcpy((void *)position, (void *)current_msg, sizeof(header_t));
+            current_msg = (volatile msg_t *)position;
+            current_vpos = vpos;
+            // move data_ptr after the new location of the header
+            data_ptr = position + sizeof(header_t);
+        }
+        return SUCCEED;
     }
-    else
-    {
-        data_ptr = (uint8_t *)current_msg;
-    }
+    data_ptr = (uint8_t *)current_msg;
+    return FAILED;
 }
 /******************************************************************************
  * @brief Finish the current message
+ * @warning This function have to be called from IRQ or with IRQ disabled.
  * @return None
  ******************************************************************************/
 void MsgAlloc_EndMsg(void)
+{
+    MsgAlloc_StoreMsg(MsgAlloc_GetPriority(&current_msg->header));
+}
+/******************************************************************************
+ * @brief Store the current message into a msg_tasks lane and prepare the next one
+ * @warning This function have to be called from IRQ or with IRQ disabled.
+ * @param priority : lane of the message
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_StoreMsg(uint8_t priority)
 {
     //******** End the message **********
-    //clean the memory zone
-    MsgAlloc_ClearMsgSpace((void *)current_msg, (void *)data_ptr);
-
     // Store the received message
-    if (msg_tasks_stack_id == MAX_MSG_NB)
+    if (MsgAlloc_IsTaskFull(priority))
     {
-        // There is no more space on the msg_tasks, remove the oldest msg.
-        MsgAlloc_ClearMsgTask();
-        if (mem_stat->msg_drop_number < 0xFF)
+        if (overflow_policy != DROP_OLDEST)
         {
-            mem_stat->msg_drop_number++;
+            // There is no more space on the msg_tasks, drop this msg and receive the next one at its place.
+            MSGALLOC_COUNT_DROP(mem_stat->task_full_drop);
+            data_ptr = (uint8_t *)current_msg;
+            return;
         }
+        // There is no more space on the msg_tasks, the oldest msg will be overwritten and skipped by Robus_Loop.
     }
-    LUOS_ASSERT(msg_tasks[msg_tasks_stack_id] == 0);
-    LUOS_ASSERT(!(msg_tasks_stack_id > 0) || (((uint32_t)msg_tasks[0] >= (uint32_t)&msg_buffer[0]) && ((uint32_t)msg_tasks[0] < (uint32_t)&msg_buffer[MSG_BUFFER_SIZE])));
-    msg_tasks[msg_tasks_stack_id] = current_msg;
-    msg_tasks_stack_id++;
-    //******** Prepare the next msg *********
+    volatile msg_task_t *slot = &msg_tasks[priority][msg_tasks_tail[priority]];
+    slot->msg_pt = (msg_t *)current_msg;
+    slot->vpos = current_vpos;
+    // publish the slot
+    slot->seq = msg_tasks_in[priority];
+    msg_tasks_tail[priority] = MsgAlloc_NextMsgTaskId(msg_tasks_tail[priority]);
+    msg_tasks_in[priority]++;
+    MsgAlloc_PrepareNextMsg();
+}
+/******************************************************************************
+ * @brief Prepare the reception of the message following the current one
+ * @warning This function have to be called from IRQ or with IRQ disabled.
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_PrepareNextMsg(void)
+{
     //data_ptr is actually 2 bytes after the message data because of the CRC. Remove the CRC.
     data_ptr -= 2;
     // clean space between data_ptr (data_ptr + sizeof(header_t)+2)
-    if (MsgAlloc_DoWeHaveSpace((void *)(data_ptr + sizeof(header_t) + 2)) == FAILED)
-    {
-        data_ptr = &msg_buffer[0];
-    }
-    else
+    if (MsgAlloc_DoWeHaveSpace((void *)(data_ptr + sizeof(header_t) + 2)) == SUCCEED)
     {
         if (*data_ptr % 2 != 1)
         {
             data_ptr++;
         }
     }
-    // update the current_msg
-    current_msg = (volatile msg_t *)data_ptr;
-    // create a task to clear this space
-    MsgAlloc_ClearMsgSpace((void *)current_msg, (void *)(&current_msg->stream[sizeof(header_t) + 2]));
+    MsgAlloc_PrepareHeader(data_ptr);
 }
 /******************************************************************************
  * @brief write a byte into the current message.
@@ -281,159 +739,558 @@ void MsgAlloc_SetData(uint8_t data)
     *data_ptr = data;
     data_ptr++;
 }
+/******************************************************************************
+ * @brief write a block of bytes into the current message.
+ * @param data : bytes to write in the allocator
+ * @param size : number of bytes
+ * @return None
+ ******************************************************************************/
+void MsgAlloc_SetDataBlock(const uint8_t *data, uint16_t size)
+{
+    // ValidHeader always keep enough contiguous space for the message, we can copy without wrapping
+    memcpy((void *)data_ptr, (const void *)data, size);
+    data_ptr += size;
+}
 /******************************************************************************
  * @brief write a complete message from localhost management.
  * @param msg_t* msg to write in the allocator
- * @return None
+ * @return error_return_t : FAILED if there is no space to save it
  ******************************************************************************/
-void MsgAlloc_SetMessage(msg_t *msg)
+error_return_t MsgAlloc_SetMessage(msg_t *msg)
 {
-    //******** Clean the message space **********
-    // Be sure that the end of msg_buffer is after data_ptr + header_t.size + header_t
-    uint16_t data_size = 0;
     msg_t *cpy_msg;
-    if (msg->header.size > MAX_DATA_MSG_SIZE)
-    {
-        data_size = MAX_DATA_MSG_SIZE + sizeof(header_t);
-    }
-    else
-    {
-        data_size = msg->header.size + sizeof(header_t);
-    }
-
-    LuosHAL_SetIrqState(false);
-    if (MsgAlloc_DoWeHaveSpace((void *)(&current_msg->stream[data_size])) == FAILED)
+    uint16_t data_size = msg->header.size;
+    if (data_size > MAX_FRAME_DATA_SIZE)
     {
-        // We are at the end of msg_buffer, we need to move the current space to the begin of msg_buffer
-        // Move current_msg to msg_buffer
-        current_msg = (volatile msg_t *)&msg_buffer[0];
+        data_size = MAX_FRAME_DATA_SIZE;
     }
-    MsgAlloc_ClearMsgSpace((void *)current_msg, (void *)(&current_msg->stream[data_size]));
-
-    //******** finish the message**********
-    /* 
-     * To prevent reception concurency, before copying any data we have to prepare
-     * the reception of the next one in a thread safe code part.
+    /*
+     * To prevent reception concurency, the message space is reserved and the
+     * reception of the next one is prepared in a thread safe code part.
      * Then we can copy it without trouble.
      */
-    // backup the message to copy location allowing current_msg to be used by reception
-    cpy_msg = (msg_t *)current_msg;
-    // fake the data_ptr progression to be able to receive other messages during the copy
-    data_ptr = &current_msg->stream[data_size + 2];
-    // finish the message and prepare the next reception
-    MsgAlloc_EndMsg();
-    LuosHAL_SetIrqState(true);
-
+    if (MsgAlloc_ReserveMsg(data_size, &cpy_msg) == FAILED)
+    {
+        // msg_buffer is locked, drop this message
+        MSGALLOC_COUNT_DROP(mem_stat->buffer_full_drop);
+        return FAILED;
+    }
     //******** Write data *********
-    memcpy((void *)cpy_msg, (void *)msg, data_size);
+    memcpy((void *)cpy_msg, (void *)msg, sizeof(header_t) + data_size);
+    return MsgAlloc_CommitMsg(cpy_msg);
 }
 /******************************************************************************
- * @brief No message in buffer receive since initialization
- * @param None
- * @return msg_t* sucess or fail if good init
+ * @brief reserve a message space into msg_buffer allowing to write a localhost message without copy
+ * @param data_size : maximum data size of the message
+ * @param reserved : the reserved message pointer
+ * @return error_return_t : FAILED if there is already a reserved message or msg_buffer is locked
  ******************************************************************************/
-error_return_t MsgAlloc_IsEmpty(void)
+error_return_t MsgAlloc_ReserveMsg(uint16_t data_size, msg_t **reserved)
 {
-    if (data_ptr == &msg_buffer[0])
+    volatile uint8_t *position;
+    uint32_t vpos;
+    uint16_t full_size = sizeof(header_t) + data_size + 2;
+    if ((reserved_msg != NULL) || (data_size > MAX_FRAME_DATA_SIZE))
     {
-        return SUCCEED;
+        return FAILED;
     }
-    else
+    // Wait the end of the message actually received
+    while (1)
+    {
+        LuosHAL_SetIrqState(false);
+        if (data_ptr == (uint8_t *)current_msg)
+        {
+            break;
+        }
+        LuosHAL_SetIrqState(true);
+    }
+    if (current_msg == (volatile msg_t *)&drop_buffer[0])
+    {
+        LuosHAL_SetIrqState(true);
+        return FAILED;
+    }
+    if ((overflow_policy != DROP_OLDEST) && MsgAlloc_IsTaskFull(NORMAL_PRIORITY))
+    {
+        // There is no more space on the msg_tasks
+        LuosHAL_SetIrqState(true);
+        MSGALLOC_COUNT_DROP(mem_stat->task_full_drop);
+        return FAILED;
+    }
+    //******** Find the message space **********
+    position = (uint8_t *)current_msg;
+    vpos = current_vpos;
+    MsgAlloc_WrapMsg(&position, &vpos, full_size);
+    if (MsgAlloc_IsHighPrioritySpace(NORMAL_PRIORITY, vpos, full_size) || MsgAlloc_IsLocked(vpos, full_size))
     {
+        LuosHAL_SetIrqState(true);
         return FAILED;
     }
+    // publish the space of the message before writing it
+    MsgAlloc_SetWriteEnd(vpos + full_size);
+    //******** finish the message**********
+    // fake the data_ptr progression to be able to receive other messages during the message filling
+    current_msg = (volatile msg_t *)position;
+    current_vpos = vpos;
+    // StoreMsg remove the CRC of received messages, keep it here because Robus_SendMsg write it into the reserved message
+    data_ptr = position + full_size + 2;
+    reserved_task_id = msg_tasks_tail[NORMAL_PRIORITY];
+    reserved_task_seq = msg_tasks_in[NORMAL_PRIORITY];
+    // lock this space until the message is commited
+    reserved_msg = (volatile msg_t *)position;
+    reserved_end = position + full_size;
+    reserved_vpos = vpos;
+    // finish the message and prepare the next reception, the header is not writen yet so localhost messages use the normal lane
+    MsgAlloc_StoreMsg(NORMAL_PRIORITY);
+    LuosHAL_SetIrqState(true);
+    *reserved = (msg_t *)position;
+    return SUCCEED;
 }
-
-/*******************************************************************************
- * Functions --> Allocator task stack
- ******************************************************************************/
-
 /******************************************************************************
- * @brief prepare a buffer space to be usable by cleaning remaining messages and prepare pointers
- * @param from : start of the memory space to clean
- * @param to : start of the memory space to clean
- * @return error_return_t
+ * @brief allocate a message space into msg_buffer for a message interpreted right now (without msg_tasks)
+ * @param data_size : data size of the message
+ * @param allocated : the allocated message pointer
+ * @return error_return_t : FAILED if msg_buffer is locked
  ******************************************************************************/
-static inline error_return_t MsgAlloc_ClearMsgSpace(void *from, void *to)
+error_return_t MsgAlloc_AllocMsgToInterpret(uint16_t data_size, msg_t **allocated)
 {
-    //******** Check if there is sufficient space on the buffer **********
-    if ((uint32_t)to > ((uint32_t)&msg_buffer[MSG_BUFFER_SIZE - 1]))
+    volatile uint8_t *position;
+    uint32_t vpos;
+    uint16_t full_size = sizeof(header_t) + data_size + 2;
+    if (data_size > MAX_FRAME_DATA_SIZE)
     {
-        // We reach msg_buffer end return an error
         return FAILED;
     }
-    //******** Prepare a memory space to be writable **********
-
-    // check if there is a msg traitement pending
-    if (((uint32_t)used_msg >= (uint32_t)from) && ((uint32_t)used_msg <= (uint32_t)to))
+    // Wait the end of the message actually received
+    while (1)
     {
-        used_msg = NULL;
-        // This message is in the space we want to use, clear the task
-        if (mem_stat->msg_drop_number < 0xFF)
+        LuosHAL_SetIrqState(false);
+        if (data_ptr == (uint8_t *)current_msg)
         {
-            mem_stat->msg_drop_number++;
+            break;
         }
+        LuosHAL_SetIrqState(true);
     }
-    while (((uint32_t)luos_tasks[0].msg_pt >= (uint32_t)from) && ((uint32_t)luos_tasks[0].msg_pt <= (uint32_t)to) && (luos_tasks_stack_id > 0))
+    if (current_msg == (volatile msg_t *)&drop_buffer[0])
     {
-        // This message is in the space we want to use, clear the task
-        MsgAlloc_ClearLuosTask(0);
-        if (mem_stat->msg_drop_number < 0xFF)
-        {
-            mem_stat->msg_drop_number++;
-        }
+        LuosHAL_SetIrqState(true);
+        MSGALLOC_COUNT_DROP(mem_stat->buffer_full_drop);
+        return FAILED;
     }
-    // check if there is no msg between from and to on msg_tasks
-    while (((uint32_t)msg_tasks[0] >= (uint32_t)from) && ((uint32_t)msg_tasks[0] <= (uint32_t)to) && (msg_tasks_stack_id > 0))
+    //******** Find the message space **********
+    position = (uint8_t *)current_msg;
+    vpos = current_vpos;
+    MsgAlloc_WrapMsg(&position, &vpos, full_size);
+    if (MsgAlloc_IsLocked(vpos, full_size))
     {
-        // This message is in the space we want to use, clear the task
-        MsgAlloc_ClearMsgTask();
-        if (mem_stat->msg_drop_number < 0xFF)
-        {
-            mem_stat->msg_drop_number++;
-        }
+        LuosHAL_SetIrqState(true);
+        MSGALLOC_COUNT_DROP(mem_stat->buffer_full_drop);
+        return FAILED;
     }
-    // if we go here there is no reason to continue because newest messages can't overlap the memory zone.
+    // publish the space of the message before writing it
+    MsgAlloc_SetWriteEnd(vpos + full_size);
+    // This message is the interpreted one, luos tasks created from it will use its position
+    interpreted_vpos = vpos;
+    MsgAlloc_UpdateRelease();
+    // prepare the next reception after it
+    data_ptr = position + full_size;
+    MsgAlloc_PrepareNextMsg();
+    LuosHAL_SetIrqState(true);
+    *allocated = (msg_t *)position;
     return SUCCEED;
 }
-/*******************************************************************************
- * Functions --> msg interpretation task stack
- ******************************************************************************/
-
 /******************************************************************************
- * @brief Clear a slot. This action is due to an error
- * @param None
- * @return None
+ * @brief make a reserved message available for interpretation
+ * @param msg : the reserved message
+ * @return error_return_t : FAILED if this message is not the reserved one
  ******************************************************************************/
-static inline void MsgAlloc_ClearMsgTask(void)
+error_return_t MsgAlloc_CommitMsg(msg_t *msg)
 {
-    LUOS_ASSERT((msg_tasks_stack_id <= MAX_MSG_NB) & (msg_tasks_stack_id > 0));
-
-    for (uint16_t rm = 0; rm < msg_tasks_stack_id; rm++)
+    uint16_t data_size = msg->header.size;
+    if (data_size > MAX_FRAME_DATA_SIZE)
+    {
+        data_size = MAX_FRAME_DATA_SIZE;
+    }
+    LuosHAL_SetIrqState(false);
+    if ((reserved_msg == NULL) || (msg != (msg_t *)reserved_msg))
     {
-        LuosHAL_SetIrqState(TRUE);
-        LuosHAL_SetIrqState(FALSE);
-        msg_tasks[rm] = msg_tasks[rm + 1];
+        LuosHAL_SetIrqState(true);
+        return FAILED;
     }
-    msg_tasks_stack_id--;
-    msg_tasks[msg_tasks_stack_id] = 0;
-    LuosHAL_SetIrqState(TRUE);
+    // The message can't be bigger than the reserved space
+    LUOS_ASSERT((uint32_t)&msg->data[data_size + 2] <= (uint32_t)reserved_end);
+    // If msg_tasks was full the reserved msg_tasks slot may have been overwritten, in this case the message is lost.
+    reserved_msg = NULL;
+    MsgAlloc_Unlock();
+    LuosHAL_SetIrqState(true);
+    return SUCCEED;
 }
 /******************************************************************************
- * @brief Pull a message that is not interpreted by robus yet
- * @param returned_msg : The message pointer.
- * @return error_return_t
+ * @brief release a reserved message without interpreting it
+ * @param msg : the reserved message
+ * @return None
  ******************************************************************************/
-error_return_t MsgAlloc_PullMsgToInterpret(msg_t **returned_msg)
+void MsgAlloc_CancelMsg(msg_t *msg)
 {
-    if (msg_tasks_stack_id > 0)
+    LuosHAL_SetIrqState(false);
+    if ((reserved_msg != NULL) && (msg == (msg_t *)reserved_msg))
     {
-        *returned_msg = (msg_t *)msg_tasks[0];
-        LUOS_ASSERT(((uint32_t)*returned_msg >= (uint32_t)&msg_buffer[0]) && ((uint32_t)*returned_msg < (uint32_t)&msg_buffer[MSG_BUFFER_SIZE]));
-        MsgAlloc_ClearMsgTask();
-        return SUCCEED;
+        volatile msg_task_t *slot = &msg_tasks[NORMAL_PRIORITY][reserved_task_id];
+        if ((slot->seq == reserved_task_seq) && (slot->msg_pt == (msg_t *)reserved_msg))
+        {
+            // keep the slot to save msg_tasks order but invalidate it, Robus_Loop will skip it
+            slot->msg_pt = NULL;
+        }
+        reserved_msg = NULL;
+        MsgAlloc_Unlock();
+    }
+    LuosHAL_SetIrqState(true);
+}
+/******************************************************************************
+ * @brief No message in buffer receive since initialization
+ * @param None
+ * @return msg_t* sucess or fail if good init
+ ******************************************************************************/
+error_return_t MsgAlloc_IsEmpty(void)
+{
+    if (data_ptr == &msg_buffer[0])
+    {
+        return SUCCEED;
+    }
+    else
+    {
+        return FAILED;
+    }
+}
+
+/*******************************************************************************
+ * Functions --> Allocator task stack
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief check if a message have been overwritten by reception
+ * @param vpos : virtual position of the message
+ * @return true if the message is not valid anymore
+ ******************************************************************************/
+static inline uint8_t MsgAlloc_IsOverwritten(uint32_t vpos)
+{
+    return ((int32_t)(write_vend - vpos) > (int32_t)(MSG_BUFFER_SIZE));
+}
+/******************************************************************************
+ * @brief publish the virtual position of the oldest message still needed by loops
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_UpdateRelease(void)
+{
+    // Messages received after this point are newer than all the messages we look at
+    uint32_t release = current_vpos;
+    for (uint16_t i = 0; i < PRIORITY_NB; i++)
+    {
+        if (((uint16_t)(msg_tasks_in[i] - msg_tasks_out[i]) > 0) && ((int32_t)(msg_tasks[i][msg_tasks_head[i]].vpos - release) < 0))
+        {
+            release = msg_tasks[i][msg_tasks_head[i]].vpos;
+        }
+    }
+    if ((interpreting == true) && ((int32_t)(interpreted_vpos - release) < 0))
+    {
+        release = interpreted_vpos;
+    }
+    if ((used_msg != NULL) && ((int32_t)(used_vpos - release) < 0))
+    {
+        release = used_vpos;
+    }
+    if ((luos_tasks_stack_id > 0) && ((int32_t)(luos_tasks[luos_tasks_order.first].vpos - release) < 0))
+    {
+        release = luos_tasks[luos_tasks_order.first].vpos;
+    }
+    release_vpos = release;
+}
+/******************************************************************************
+ * @brief publish the virtual position of the oldest pinned message
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_UpdatePin(void)
+{
+    uint8_t first = true;
+    uint32_t oldest = 0;
+    for (uint16_t i = 0; i < MAX_PINNED_MSG; i++)
+    {
+        if ((pinned_msgs[i].ref_nbr > 0) && ((first == true) || ((int32_t)(pinned_msgs[i].vpos - oldest) < 0)))
+        {
+            oldest = pinned_msgs[i].vpos;
+            first = false;
+        }
+    }
+    for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+    {
+        if ((batch_pins[i].first_msg != NULL) && ((first == true) || ((int32_t)(batch_pins[i].first_vpos - oldest) < 0)))
+        {
+            oldest = batch_pins[i].first_vpos;
+            first = false;
+        }
+    }
+    pinned_vpos = oldest;
+}
+/******************************************************************************
+ * @brief pin a message into the pin table
+ * @param msg : The message to pin
+ * @param vpos : virtual position of the message
+ * @return error_return_t : FAILED if this message is not valid anymore or the pin table is full
+ ******************************************************************************/
+static inline error_return_t MsgAlloc_Pin(msg_t *msg, uint32_t vpos)
+{
+    uint16_t free_slot = MAX_PINNED_MSG;
+    for (uint16_t i = 0; i < MAX_PINNED_MSG; i++)
+    {
+        if ((pinned_msgs[i].ref_nbr > 0) && (pinned_msgs[i].msg_pt == msg))
+        {
+            // This message is already pinned
+            LUOS_ASSERT(pinned_msgs[i].ref_nbr < 0xFF);
+            pinned_msgs[i].ref_nbr++;
+            return SUCCEED;
+        }
+        if ((pinned_msgs[i].ref_nbr == 0) && (free_slot == MAX_PINNED_MSG))
+        {
+            free_slot = i;
+        }
+    }
+    if (free_slot == MAX_PINNED_MSG)
+    {
+        return FAILED;
+    }
+    // Publish the pin before checking the message, IT will not overwrite it anymore
+    pinned_msgs[free_slot].msg_pt = msg;
+    pinned_msgs[free_slot].vpos = vpos;
+    pinned_msgs[free_slot].ref_nbr = 1;
+    MsgAlloc_UpdatePin();
+    pinned_msg_nbr++;
+    if (MsgAlloc_IsOverwritten(vpos))
+    {
+        // This message have been overwritten before we pin it
+        MsgAlloc_UnpinMsg(msg);
+        return FAILED;
+    }
+    return SUCCEED;
+}
+/******************************************************************************
+ * @brief check if a message is between the oldest and the newest message of a batch
+ * @param batch : The pending batch
+ * @param msg : The message to check
+ * @return true if the message is into the batch space
+ ******************************************************************************/
+static inline uint8_t MsgAlloc_IsInBatch(volatile batch_pin_t *batch, msg_t *msg)
+{
+    // The batch space is smaller than msg_buffer, compare the distances on the ring
+    uint32_t msg_distance = ((uint32_t)msg - (uint32_t)batch->first_msg + MSG_BUFFER_SIZE) % (MSG_BUFFER_SIZE);
+    uint32_t batch_distance = ((uint32_t)batch->last_msg - (uint32_t)batch->first_msg + MSG_BUFFER_SIZE) % (MSG_BUFFER_SIZE);
+    return (msg_distance <= batch_distance);
+}
+/******************************************************************************
+ * @brief add a message to the pending batch of a ll_container
+ * @param container_index : Index of the ll_container pulling the batch
+ * @param msg : The message to pin
+ * @param vpos : virtual position of the message
+ * @return error_return_t : FAILED if this message is not valid anymore
+ ******************************************************************************/
+static inline error_return_t MsgAlloc_PinBatch(uint16_t container_index, msg_t *msg, uint32_t vpos)
+{
+    volatile batch_pin_t *batch = &batch_pins[container_index];
+    batch_pin_t previous = *batch;
+    if (batch->first_msg == NULL)
+    {
+        batch->first_msg = msg;
+        batch->first_vpos = vpos;
+        batch->last_msg = msg;
+        batch->last_vpos = vpos;
+        pinned_msg_nbr++;
+    }
+    else if ((int32_t)(vpos - batch->first_vpos) < 0)
+    {
+        // A reserved message can be older than the messages already into the batch
+        batch->first_msg = msg;
+        batch->first_vpos = vpos;
+    }
+    else if ((int32_t)(vpos - batch->last_vpos) > 0)
+    {
+        batch->last_msg = msg;
+        batch->last_vpos = vpos;
+    }
+    // Publish the pin before checking the message, IT will not overwrite it anymore
+    MsgAlloc_UpdatePin();
+    if (MsgAlloc_IsOverwritten(vpos))
+    {
+        // This message have been overwritten before we pin it, restore the batch
+        *batch = previous;
+        if (previous.first_msg == NULL)
+        {
+            pinned_msg_nbr--;
+        }
+        MsgAlloc_UpdatePin();
+        return FAILED;
+    }
+    return SUCCEED;
+}
+/******************************************************************************
+ * @brief keep a message valid into msg_buffer until it is unpinned
+ * @param msg : The message to pin, it have to be the last pulled message, the reserved one, a message of a pending batch or an already pinned one
+ * @return error_return_t : FAILED if this message is not valid anymore or the pin table is full
+ ******************************************************************************/
+error_return_t MsgAlloc_PinMsg(msg_t *msg)
+{
+    for (uint16_t i = 0; i < MAX_PINNED_MSG; i++)
+    {
+        if ((pinned_msgs[i].ref_nbr > 0) && (pinned_msgs[i].msg_pt == msg))
+        {
+            return MsgAlloc_Pin(msg, pinned_msgs[i].vpos);
+        }
+    }
+    for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+    {
+        if ((batch_pins[i].first_msg != NULL) && (MsgAlloc_IsInBatch(&batch_pins[i], msg) == true))
+        {
+            // Everything from the oldest message of the batch is valid
+            return MsgAlloc_Pin(msg, batch_pins[i].first_vpos);
+        }
+    }
+    if ((reserved_msg != NULL) && (msg == (msg_t *)reserved_msg))
+    {
+        // The reserved space stay valid after its commit or cancel
+        return MsgAlloc_Pin(msg, reserved_vpos);
+    }
+    if ((msg == NULL) || (msg != (msg_t *)used_msg))
+    {
+        return FAILED;
+    }
+    return MsgAlloc_Pin(msg, used_vpos);
+}
+/******************************************************************************
+ * @brief release a pinned message
+ * @param msg : The pinned message
+ * @return error_return_t : FAILED if this message is not pinned
+ ******************************************************************************/
+error_return_t MsgAlloc_UnpinMsg(msg_t *msg)
+{
+    for (uint16_t i = 0; i < MAX_PINNED_MSG; i++)
+    {
+        if ((pinned_msgs[i].ref_nbr > 0) && (pinned_msgs[i].msg_pt == msg))
+        {
+            pinned_msgs[i].ref_nbr--;
+            if (pinned_msgs[i].ref_nbr == 0)
+            {
+                // Nobody need this message anymore, release its space
+                pinned_msgs[i].msg_pt = NULL;
+                pinned_msg_nbr--;
+                MsgAlloc_UpdatePin();
+            }
+            return SUCCEED;
+        }
     }
-    // At this point we don't find any message for this module
+    return FAILED;
+}
+/******************************************************************************
+ * @brief release all the messages pulled by a ll_container using MsgAlloc_PullMsgBatch
+ * @param target_module : The module releasing its batch
+ * @return error_return_t : FAILED if this module have no pending batch
+ ******************************************************************************/
+error_return_t MsgAlloc_UnpinMsgBatch(ll_container_t *target_module)
+{
+    volatile batch_pin_t *batch = &batch_pins[MsgAlloc_GetContainerIndex(target_module)];
+    if (batch->first_msg == NULL)
+    {
+        return FAILED;
+    }
+    batch->first_msg = NULL;
+    pinned_msg_nbr--;
+    MsgAlloc_UpdatePin();
+    return SUCCEED;
+}
+/*******************************************************************************
+ * Functions --> msg interpretation task stack
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief Get the msg_tasks id following the given one on the ring queue
+ * @param msg_task_id : current msg_tasks id
+ * @return next msg_tasks id
+ ******************************************************************************/
+static inline uint16_t MsgAlloc_NextMsgTaskId(uint16_t msg_task_id)
+{
+    msg_task_id++;
+    if (msg_task_id == MAX_MSG_NB)
+    {
+        msg_task_id = 0;
+    }
+    return msg_task_id;
+}
+/******************************************************************************
+ * @brief Pull a message that is not interpreted by robus yet, high priority messages first
+ * @param returned_msg : The message pointer.
+ * @return error_return_t
+ ******************************************************************************/
+error_return_t MsgAlloc_PullMsgToInterpret(msg_t **returned_msg)
+{
+    // The previous message is interpreted
+    interpreting = false;
+    for (int16_t priority = PRIORITY_NB - 1; priority >= 0; priority--)
+    {
+        uint16_t reserved_nbr = 0;
+        if ((priority == NORMAL_PRIORITY) && (high_task_nbr < HIGH_PRIORITY_TASK_NB))
+        {
+            reserved_nbr = HIGH_PRIORITY_TASK_NB - high_task_nbr;
+        }
+        if ((overflow_policy == BACKPRESSURE) && (luos_tasks_stack_id + reserved_nbr >= MAX_MSG_NB))
+        {
+            // Keep messages into msg_tasks until Luos consume some tasks, this will make reception NAK new messages.
+            continue;
+        }
+        while ((uint16_t)(msg_tasks_in[priority] - msg_tasks_out[priority]) > 0)
+        {
+            if ((uint16_t)(msg_tasks_in[priority] - msg_tasks_out[priority]) > MAX_MSG_NB)
+            {
+                // The oldest msg_tasks have been overwritten by reception, skip them.
+                MSGALLOC_COUNT_DROP(mem_stat->task_evict_drop);
+                msg_tasks_out[priority]++;
+                msg_tasks_head[priority] = MsgAlloc_NextMsgTaskId(msg_tasks_head[priority]);
+                continue;
+            }
+            volatile msg_task_t *slot = &msg_tasks[priority][msg_tasks_head[priority]];
+            uint16_t seq = slot->seq;
+            msg_t *msg = slot->msg_pt;
+            uint32_t vpos = slot->vpos;
+            if ((seq != slot->seq) || (seq != msg_tasks_out[priority]))
+            {
+                // This slot have been overwritten during the reading, try again.
+                continue;
+            }
+            if ((reserved_msg != NULL) && (msg == (msg_t *)reserved_msg))
+            {
+                // This message is not commited yet, wait for it to keep the messages order.
+                break;
+            }
+            msg_tasks_out[priority]++;
+            msg_tasks_head[priority] = MsgAlloc_NextMsgTaskId(msg_tasks_head[priority]);
+            if (msg == NULL)
+            {
+                // This is a canceled reservation
+                continue;
+            }
+            if (MsgAlloc_IsOverwritten(vpos))
+            {
+                // This message have been overwritten by reception
+                MSGALLOC_COUNT_DROP(mem_stat->buffer_evict_drop);
+                continue;
+            }
+            LUOS_ASSERT(((uint32_t)msg >= (uint32_t)&msg_buffer[0]) && ((uint32_t)msg < (uint32_t)&msg_buffer[MSG_BUFFER_SIZE]));
+            interpreted_vpos = vpos;
+            interpreting = true;
+            MsgAlloc_UpdateRelease();
+            *returned_msg = msg;
+            return SUCCEED;
+        }
+    }
+    MsgAlloc_UpdateRelease();
+    // At this point we don't find any message for this module
     return FAILED;
 }
 
@@ -442,52 +1299,380 @@ error_return_t MsgAlloc_PullMsgToInterpret(msg_t **returned_msg)
  ******************************************************************************/
 
 /******************************************************************************
- * @brief prepare a buffer space to be usable by cleaning remaining messages and prepare pointers
- * @param from : start of the memory space to clean
- * @param to : start of the memory space to clean
- * @return error_return_t
+ * @brief release the message used by the last pulled luos task
+ * @param None
+ * @return None
  ******************************************************************************/
 void MsgAlloc_UsedMsgEnd(void)
 {
     used_msg = NULL;
+    MsgAlloc_UpdateRelease();
 }
 /******************************************************************************
- * @brief Clear a slot. This action is due to an error
+ * @brief Remove the oldest luos_tasks if their messages have been overwritten by reception
  * @param None
  * @return None
  ******************************************************************************/
+static inline void MsgAlloc_ClearOverwrittenLuosTasks(void)
+{
+    while ((luos_tasks_stack_id > 0) && MsgAlloc_IsOverwritten(luos_tasks[luos_tasks_order.first].vpos))
+    {
+        MsgAlloc_DropLuosTask(luos_tasks_order.first);
+        MSGALLOC_COUNT_DROP(mem_stat->buffer_evict_drop);
+    }
+}
+/******************************************************************************
+ * @brief Get the index of a ll_container into the context table
+ * @param ll_container : The ll_container pointer
+ * @return ll_container index
+ ******************************************************************************/
+static inline uint16_t MsgAlloc_GetContainerIndex(ll_container_t *ll_container)
+{
+    LUOS_ASSERT(((uint32_t)ll_container >= (uint32_t)&ctx.ll_container_table[0]) && ((uint32_t)ll_container < (uint32_t)&ctx.ll_container_table[MAX_CONTAINER_NUMBER]));
+    return (uint16_t)(ll_container - (ll_container_t *)&ctx.ll_container_table[0]);
+}
+/******************************************************************************
+ * @brief Count the number of ll_containers into a mask
+ * @param container_mask : mask of ll_container index
+ * @return number of ll_containers
+ ******************************************************************************/
+static inline uint16_t MsgAlloc_CountContainers(container_mask_t container_mask)
+{
+    uint16_t nbr = 0;
+    while (container_mask)
+    {
+        container_mask &= container_mask - 1;
+        nbr++;
+    }
+    return nbr;
+}
+/******************************************************************************
+ * @brief Move the oldest shared task of a ll_container to the next one it didn't consume yet
+ * @warning This function have to be called from loops.
+ * @param container_index : Index of the ll_container
+ * @param luos_task_id : Shared task id to start from
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_UpdateSharedFirst(uint16_t container_index, uint16_t luos_task_id)
+{
+    while ((luos_task_id != NO_LUOS_TASK) && !(luos_tasks[luos_task_id].container_mask & ((container_mask_t)1 << container_index)))
+    {
+        luos_task_id = luos_tasks[luos_task_id].container_next;
+    }
+    shared_tasks_first[container_index] = luos_task_id;
+}
+/******************************************************************************
+ * @brief Clear a slot by unchaining it from the arrival order and from its ll_container FIFO
+ * @warning This function have to be called from loops.
+ * @param luos_task_id : Id of the luos_tasks slot to clear
+ * @return None
+ ******************************************************************************/
 static inline void MsgAlloc_ClearLuosTask(uint16_t luos_task_id)
 {
-    LUOS_ASSERT((luos_task_id <= luos_tasks_stack_id) || (luos_tasks_stack_id <= MAX_MSG_NB));
-    for (uint16_t rm = luos_task_id; rm < luos_tasks_stack_id; rm++)
+    LUOS_ASSERT((luos_task_id < MAX_MSG_NB) && (luos_tasks_stack_id > 0));
+    volatile luos_task_t *task = &luos_tasks[luos_task_id];
+    volatile luos_task_fifo_t *container_fifo;
+
+    // The positions of the interpretation order change
+    luos_tasks_cursor.valid = false;
+    if (task->ll_container_pt == NULL)
+    {
+        // This is a shared task, remove all its remaining consumers
+        container_fifo = &shared_tasks;
+        luos_tasks_delivery_nbr -= MsgAlloc_CountContainers(task->container_mask);
+        for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+        {
+            if (shared_tasks_first[i] == luos_task_id)
+            {
+                MsgAlloc_UpdateSharedFirst(i, task->container_next);
+            }
+        }
+    }
+    else
     {
-        luos_tasks[rm] = luos_tasks[rm + 1];
+        uint16_t container_index = MsgAlloc_GetContainerIndex(task->ll_container_pt);
+        container_fifo = &container_tasks[container_index];
+        luos_tasks_delivery_nbr--;
+        container_task_nbr[container_index]--;
+        container_byte_nbr[container_index] -= task->byte_nbr;
     }
-    LuosHAL_SetIrqState(FALSE);
-    if (luos_tasks_stack_id != 0)
+    // Unchain the task from the arrival order
+    if (task->prev == NO_LUOS_TASK)
+    {
+        luos_tasks_order.first = task->next;
+    }
+    else
     {
-        luos_tasks_stack_id--;
+        luos_tasks[task->prev].next = task->next;
     }
-    LuosHAL_SetIrqState(TRUE);
+    if (task->next == NO_LUOS_TASK)
+    {
+        luos_tasks_order.last = task->prev;
+    }
+    else
+    {
+        luos_tasks[task->next].prev = task->prev;
+    }
+    // Unchain the task from the ll_container FIFO or from the shared tasks list
+    if (task->container_prev == NO_LUOS_TASK)
+    {
+        container_fifo->first = task->container_next;
+    }
+    else
+    {
+        luos_tasks[task->container_prev].container_next = task->container_next;
+    }
+    if (task->container_next == NO_LUOS_TASK)
+    {
+        container_fifo->last = task->container_prev;
+    }
+    else
+    {
+        luos_tasks[task->container_next].container_prev = task->container_prev;
+    }
+    if (task->priority == HIGH_PRIORITY)
+    {
+        high_task_nbr--;
+    }
+    // Give the slot back to the free list
+    task->msg_pt = NULL;
+    task->ll_container_pt = NULL;
+    task->container_mask = 0;
+    task->next = luos_tasks_free;
+    luos_tasks_free = luos_task_id;
+    luos_tasks_stack_id--;
 }
 /******************************************************************************
- * @brief Alloc luos task
- * @param module_concerned_by_current_msg concerned modules
- * @param module_concerned_by_current_msg concerned msg
+ * @brief Count a message dropped before being consumed by a ll_container
+ * @param container_index : Index of the ll_container
  * @return None
  ******************************************************************************/
-void MsgAlloc_LuosTaskAlloc(ll_container_t *container_concerned_by_current_msg, msg_t *concerned_msg)
+static inline void MsgAlloc_CountContainerDrop(uint16_t container_index)
+{
+    uint8_t *msg_drop_nbr = ctx.ll_container_table[container_index].ll_stat.msg_drop_nbr;
+    if ((msg_drop_nbr != NULL) && (*msg_drop_nbr < 0xFF))
+    {
+        *msg_drop_nbr = *msg_drop_nbr + 1;
+    }
+}
+/******************************************************************************
+ * @brief Clear a slot whose message will never be consumed and count it for the concerned ll_containers
+ * @param luos_task_id : Id of the luos_tasks slot to drop
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_DropLuosTask(uint16_t luos_task_id)
+{
+    volatile luos_task_t *task = &luos_tasks[luos_task_id];
+    if (task->ll_container_pt == NULL)
+    {
+        for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+        {
+            if (task->container_mask & ((container_mask_t)1 << i))
+            {
+                MsgAlloc_CountContainerDrop(i);
+            }
+        }
+    }
+    else
+    {
+        MsgAlloc_CountContainerDrop(MsgAlloc_GetContainerIndex(task->ll_container_pt));
+    }
+    MsgAlloc_ClearLuosTask(luos_task_id);
+}
+/******************************************************************************
+ * @brief Get the number of free luos_tasks usable by a ll_container
+ * @param ll_container : The ll_container pointer, NULL for a shared task
+ * @param priority : priority of the message
+ * @return number of free luos_tasks not reserved for other ll_containers
+ ******************************************************************************/
+static inline uint16_t MsgAlloc_FreeLuosTasks(ll_container_t *ll_container, uint8_t priority)
 {
+    uint16_t free_nbr = MAX_MSG_NB - luos_tasks_stack_id;
+    uint16_t reserved_nbr = 0;
+    if ((priority == NORMAL_PRIORITY) && (high_task_nbr < HIGH_PRIORITY_TASK_NB))
+    {
+        reserved_nbr = HIGH_PRIORITY_TASK_NB - high_task_nbr;
+    }
+    for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+    {
+        if (((ll_container_t *)&ctx.ll_container_table[i] != ll_container) && (container_task_nbr[i] < ctx.ll_container_table[i].quota_min_task))
+        {
+            reserved_nbr += ctx.ll_container_table[i].quota_min_task - container_task_nbr[i];
+        }
+    }
+    if (reserved_nbr >= free_nbr)
+    {
+        return 0;
+    }
+    return free_nbr - reserved_nbr;
+}
+/******************************************************************************
+ * @brief Find the oldest luos_tasks that can be removed to alloc a new one to a ll_container
+ * @param ll_container : The ll_container pointer, NULL for a shared task
+ * @param priority : priority of the message, normal priority tasks are removed first
+ * @return luos_tasks id or NO_LUOS_TASK
+ ******************************************************************************/
+static inline uint16_t MsgAlloc_FindEvictableLuosTask(ll_container_t *ll_container, uint8_t priority)
+{
+    for (uint16_t evicted_priority = 0; evicted_priority <= priority; evicted_priority++)
+    {
+        uint16_t luos_task_id = luos_tasks_order.first;
+        while (luos_task_id != NO_LUOS_TASK)
+        {
+            ll_container_t *owner = luos_tasks[luos_task_id].ll_container_pt;
+            // Tasks reserved by the quota of another ll_container can't be removed
+            if ((luos_tasks[luos_task_id].priority == evicted_priority)
+                && ((owner == NULL) || (owner == ll_container) || (container_task_nbr[MsgAlloc_GetContainerIndex(owner)] > owner->quota_min_task)))
+            {
+                return luos_task_id;
+            }
+            luos_task_id = luos_tasks[luos_task_id].next;
+        }
+    }
+    return NO_LUOS_TASK;
+}
+/******************************************************************************
+ * @brief Take a free slot and chain it at the end of the arrival order
+ * @warning This function have to be called from loops.
+ * @param concerned_msg : The message concerned by this task
+ * @param ll_container : The ll_container concerned by this task, NULL for a shared task
+ * @return luos_tasks id of the new task, NO_LUOS_TASK if the message is dropped
+ ******************************************************************************/
+static inline uint16_t MsgAlloc_NewLuosTask(msg_t *concerned_msg, ll_container_t *ll_container)
+{
+    uint8_t priority = NORMAL_PRIORITY;
+    if ((concerned_msg->header.cmd < high_priority_cmd_nb) || (concerned_msg->header.cmd >= ROBUS_EXTENSION_CMD) || ((ll_container != NULL) && (ll_container->priority == HIGH_PRIORITY)))
+    {
+        priority = HIGH_PRIORITY;
+    }
     // find a free slot
-    if (luos_tasks_stack_id == MAX_MSG_NB)
+    if (MsgAlloc_FreeLuosTasks(ll_container, priority) == 0)
     {
+        uint16_t evicted_task_id = NO_LUOS_TASK;
+        if (overflow_policy == DROP_OLDEST)
+        {
+            evicted_task_id = MsgAlloc_FindEvictableLuosTask(ll_container, priority);
+        }
+        if (evicted_task_id == NO_LUOS_TASK)
+        {
+            // There is no more space on the luos_tasks, drop this msg.
+            MSGALLOC_COUNT_DROP(mem_stat->task_full_drop);
+            return NO_LUOS_TASK;
+        }
         // There is no more space on the luos_tasks, remove the oldest msg.
-        MsgAlloc_ClearLuosTask(0);
+        MsgAlloc_DropLuosTask(evicted_task_id);
+        MSGALLOC_COUNT_DROP(mem_stat->task_evict_drop);
     }
+    uint16_t luos_task_id = luos_tasks_free;
+    volatile luos_task_t *task = &luos_tasks[luos_task_id];
+    luos_tasks_free = task->next;
     // fill the informations of the message in this slot
-    luos_tasks[luos_tasks_stack_id].msg_pt = concerned_msg;
-    luos_tasks[luos_tasks_stack_id].ll_container_pt = container_concerned_by_current_msg;
+    task->msg_pt = concerned_msg;
+    task->vpos = interpreted_vpos;
+    task->byte_nbr = 0;
+    task->priority = priority;
+    if (priority == HIGH_PRIORITY)
+    {
+        high_task_nbr++;
+    }
+    if (priority > luos_tasks_cursor.priority)
+    {
+        // This task take a position before the cursor
+        luos_tasks_cursor.valid = false;
+    }
+    task->arrival = luos_tasks_arrival++;
+    // Chain it at the end of the arrival order
+    task->prev = luos_tasks_order.last;
+    task->next = NO_LUOS_TASK;
+    if (luos_tasks_order.last == NO_LUOS_TASK)
+    {
+        luos_tasks_order.first = luos_task_id;
+    }
+    else
+    {
+        luos_tasks[luos_tasks_order.last].next = luos_task_id;
+    }
+    luos_tasks_order.last = luos_task_id;
     luos_tasks_stack_id++;
+    return luos_task_id;
+}
+/******************************************************************************
+ * @brief Alloc luos task
+ * @param module_concerned_by_current_msg concerned modules
+ * @param module_concerned_by_current_msg concerned msg
+ * @return None
+ ******************************************************************************/
+void MsgAlloc_LuosTaskAlloc(ll_container_t *container_concerned_by_current_msg, msg_t *concerned_msg)
+{
+    uint16_t container_index = MsgAlloc_GetContainerIndex(container_concerned_by_current_msg);
+    volatile luos_task_fifo_t *container_fifo = &container_tasks[container_index];
+    uint16_t byte_nbr = sizeof(header_t) + concerned_msg->header.size;
+    uint16_t luos_task_id = container_fifo->first;
+    if (concerned_msg->header.size > MAX_FRAME_DATA_SIZE)
+    {
+        byte_nbr = sizeof(header_t) + MAX_FRAME_DATA_SIZE;
+    }
+    if (container_concerned_by_current_msg->coalescing == true)
+    {
+        // Only the freshest value is usefull, replace the pending message with the same source and cmd.
+        while (luos_task_id != NO_LUOS_TASK)
+        {
+            uint16_t source = luos_tasks[luos_task_id].msg_pt->header.source;
+            uint8_t cmd = luos_tasks[luos_task_id].msg_pt->header.cmd;
+            // Check it after reading the header, reception can overwrite the pending message at any time with DROP_OLDEST
+            if ((MsgAlloc_IsOverwritten(luos_tasks[luos_task_id].vpos) == false) && (source == concerned_msg->header.source) && (cmd == concerned_msg->header.cmd))
+            {
+                if (byte_nbr <= luos_tasks[luos_task_id].byte_nbr)
+                {
+                    // The new message fit into the pending one, overwrite it in place and keep its task.
+                    // The task keep its byte_nbr, this is the space it still hold into msg_buffer.
+                    memcpy((void *)luos_tasks[luos_task_id].msg_pt, concerned_msg, byte_nbr);
+                    return;
+                }
+                // The new message is bigger, it take the slot of the pending one and go at the end of the FIFO to keep arrival order coherent with msg_buffer.
+                MsgAlloc_ClearLuosTask(luos_task_id);
+                break;
+            }
+            luos_task_id = luos_tasks[luos_task_id].container_next;
+        }
+    }
+    // Apply the quotas of this ll_container
+    while (((container_concerned_by_current_msg->quota_max_task != 0) && (container_task_nbr[container_index] >= container_concerned_by_current_msg->quota_max_task))
+           || ((container_concerned_by_current_msg->quota_max_byte != 0) && (container_byte_nbr[container_index] + byte_nbr > container_concerned_by_current_msg->quota_max_byte)))
+    {
+        if ((overflow_policy != DROP_OLDEST) || (container_fifo->first == NO_LUOS_TASK))
+        {
+            // This ll_container reach its quota, drop this msg.
+            MsgAlloc_CountContainerDrop(container_index);
+            return;
+        }
+        // This ll_container reach its quota, remove its oldest msg.
+        MsgAlloc_DropLuosTask(container_fifo->first);
+    }
+    luos_task_id = MsgAlloc_NewLuosTask(concerned_msg, container_concerned_by_current_msg);
+    if (luos_task_id == NO_LUOS_TASK)
+    {
+        MsgAlloc_CountContainerDrop(container_index);
+        return;
+    }
+    volatile luos_task_t *task = &luos_tasks[luos_task_id];
+    task->ll_container_pt = container_concerned_by_current_msg;
+    task->byte_nbr = byte_nbr;
+    container_task_nbr[container_index]++;
+    container_byte_nbr[container_index] += byte_nbr;
+    // Chain it at the end of the ll_container FIFO
+    task->container_prev = container_fifo->last;
+    task->container_next = NO_LUOS_TASK;
+    if (container_fifo->last == NO_LUOS_TASK)
+    {
+        container_fifo->first = luos_task_id;
+    }
+    else
+    {
+        luos_tasks[container_fifo->last].container_next = luos_task_id;
+    }
+    container_fifo->last = luos_task_id;
+    luos_tasks_delivery_nbr++;
     // luos task memory usage
     uint8_t stat = (uint8_t)(((uint32_t)luos_tasks_stack_id * 100) / (MAX_MSG_NB));
     if (stat > mem_stat->luos_stack_ratio)
@@ -495,51 +1680,340 @@ void MsgAlloc_LuosTaskAlloc(ll_container_t *container_concerned_by_current_msg,
         mem_stat->luos_stack_ratio = stat;
     }
 }
+/******************************************************************************
+ * @brief Alloc a single luos task shared by multiple containers
+ * @param container_mask mask of the ll_container index concerned by the msg
+ * @param concerned_msg concerned msg
+ * @return None
+ ******************************************************************************/
+void MsgAlloc_LuosSharedTaskAlloc(container_mask_t container_mask, msg_t *concerned_msg)
+{
+    uint16_t container_nbr = MsgAlloc_CountContainers(container_mask);
+    if (container_nbr == 0)
+    {
+        return;
+    }
+    if (container_nbr == 1)
+    {
+        // Only one container is concerned, use its FIFO
+        uint16_t container_index = 0;
+        while (!(container_mask & ((container_mask_t)1 << container_index)))
+        {
+            container_index++;
+        }
+        MsgAlloc_LuosTaskAlloc((ll_container_t *)&ctx.ll_container_table[container_index], concerned_msg);
+        return;
+    }
+    uint16_t luos_task_id = MsgAlloc_NewLuosTask(concerned_msg, NULL);
+    if (luos_task_id == NO_LUOS_TASK)
+    {
+        for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+        {
+            if (container_mask & ((container_mask_t)1 << i))
+            {
+                MsgAlloc_CountContainerDrop(i);
+            }
+        }
+        return;
+    }
+    volatile luos_task_t *task = &luos_tasks[luos_task_id];
+    task->ll_container_pt = NULL;
+    task->container_mask = container_mask;
+    // Chain it at the end of the shared tasks list
+    task->container_prev = shared_tasks.last;
+    task->container_next = NO_LUOS_TASK;
+    if (shared_tasks.last == NO_LUOS_TASK)
+    {
+        shared_tasks.first = luos_task_id;
+    }
+    else
+    {
+        luos_tasks[shared_tasks.last].container_next = luos_task_id;
+    }
+    shared_tasks.last = luos_task_id;
+    for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+    {
+        if ((container_mask & ((container_mask_t)1 << i)) && (shared_tasks_first[i] == NO_LUOS_TASK))
+        {
+            shared_tasks_first[i] = luos_task_id;
+        }
+    }
+    luos_tasks_delivery_nbr += container_nbr;
+    // luos task memory usage
+    uint8_t stat = (uint8_t)(((uint32_t)luos_tasks_stack_id * 100) / (MAX_MSG_NB));
+    if (stat > mem_stat->luos_stack_ratio)
+    {
+        mem_stat->luos_stack_ratio = stat;
+    }
+}
+/******************************************************************************
+ * @brief Consume a task for a container and release it if nobody else need it
+ * @warning This function have to be called from loops.
+ * @param luos_task_id : Id of the luos_tasks slot to consume
+ * @param container_index : Index of the consumer ll_container
+ * @return None
+ ******************************************************************************/
+static inline void MsgAlloc_ConsumeLuosTask(uint16_t luos_task_id, uint16_t container_index)
+{
+    volatile luos_task_t *task = &luos_tasks[luos_task_id];
+    if (task->ll_container_pt == NULL)
+    {
+        // Shared task, remove this consumer
+        LUOS_ASSERT(task->container_mask & ((container_mask_t)1 << container_index));
+        task->container_mask &= ~((container_mask_t)1 << container_index);
+        luos_tasks_delivery_nbr--;
+        luos_tasks_cursor.valid = false;
+        if (task->container_mask != 0)
+        {
+            // Other containers still need this task
+            if (shared_tasks_first[container_index] == luos_task_id)
+            {
+                MsgAlloc_UpdateSharedFirst(container_index, task->container_next);
+            }
+            return;
+        }
+    }
+    MsgAlloc_ClearLuosTask(luos_task_id);
+}
+/******************************************************************************
+ * @brief Move a cursor to the next position of the interpretation order
+ *
+ * The interpretation order is not the arrival order : HIGH_PRIORITY tasks come
+ * first, then NORMAL_PRIORITY ones, each of them in arrival order. A shared
+ * task take one position per remaining consumer.
+ *
+ * @warning This function have to be called from loops.
+ * @param cursor : Cursor to move, a cursor with a NO_LUOS_TASK task_id move to the first position
+ * @return error_return_t : Fail if there is no more position
+ ******************************************************************************/
+static inline error_return_t MsgAlloc_NextLuosTask(luos_task_cursor_t *cursor)
+{
+    uint16_t luos_task_id = luos_tasks_order.first;
+    if (cursor->task_id != NO_LUOS_TASK)
+    {
+        volatile luos_task_t *task = &luos_tasks[cursor->task_id];
+        if (task->ll_container_pt == NULL)
+        {
+            // Look at the next remaining consumer of this shared task
+            for (uint16_t i = cursor->container_index + 1; i < MAX_CONTAINER_NUMBER; i++)
+            {
+                if (task->container_mask & ((container_mask_t)1 << i))
+                {
+                    cursor->container_index = i;
+                    return SUCCEED;
+                }
+            }
+        }
+        luos_task_id = task->next;
+    }
+    while (1)
+    {
+        if ((cursor->priority == HIGH_PRIORITY) && (high_task_nbr == 0))
+        {
+            // Don't scan the tasks if there is no HIGH_PRIORITY one
+            luos_task_id = NO_LUOS_TASK;
+        }
+        while (luos_task_id != NO_LUOS_TASK)
+        {
+            volatile luos_task_t *task = &luos_tasks[luos_task_id];
+            if ((task->priority == cursor->priority) && (task->ll_container_pt != NULL))
+            {
+                cursor->task_id = luos_task_id;
+                cursor->container_index = MsgAlloc_GetContainerIndex(task->ll_container_pt);
+                return SUCCEED;
+            }
+            else if (task->priority == cursor->priority)
+            {
+                // Shared task, its first remaining consumer take this position
+                for (uint16_t i = 0; i < MAX_CONTAINER_NUMBER; i++)
+                {
+                    if (task->container_mask & ((container_mask_t)1 << i))
+                    {
+                        cursor->task_id = luos_task_id;
+                        cursor->container_index = i;
+                        return SUCCEED;
+                    }
+                }
+            }
+            luos_task_id = task->next;
+        }
+        if (cursor->priority == 0)
+        {
+            return FAILED;
+        }
+        // Continue with the next priority
+        cursor->priority--;
+        luos_task_id = luos_tasks_order.first;
+    }
+}
+/******************************************************************************
+ * @brief Find the luos_tasks slot at a given position of the interpretation order
+ *
+ * Pulling a task shift the following positions, so Luos_Loop look at the same
+ * position again after a pull and only move to the next one when it keep a
+ * message for a polling container. The last position found is kept into
+ * luos_tasks_cursor, so looking at the same position again or at a following
+ * one only move this cursor instead of scanning all the pending tasks.
+ * Any change of the luos_tasks invalidate the cursor and the next lookup scan
+ * them again from the first position.
+ *
+ * @warning This function have to be called from loops.
+ * @param luos_task_position : Position of the task in the interpretation order
+ * @param container_index : Filled with the index of the ll_container concerned at this position
+ * @return luos_tasks id or NO_LUOS_TASK
+ ******************************************************************************/
+static inline uint16_t MsgAlloc_FindLuosTask(uint16_t luos_task_position, uint16_t *container_index)
+{
+    if ((luos_tasks_cursor.valid == false) || (luos_task_position < luos_tasks_cursor.position))
+    {
+        // Start again from the first position
+        luos_tasks_cursor.task_id = NO_LUOS_TASK;
+        luos_tasks_cursor.priority = PRIORITY_NB - 1;
+        if (MsgAlloc_NextLuosTask(&luos_tasks_cursor) == FAILED)
+        {
+            return NO_LUOS_TASK;
+        }
+        luos_tasks_cursor.position = 0;
+        luos_tasks_cursor.valid = true;
+    }
+    while (luos_tasks_cursor.position < luos_task_position)
+    {
+        if (MsgAlloc_NextLuosTask(&luos_tasks_cursor) == FAILED)
+        {
+            luos_tasks_cursor.valid = false;
+            return NO_LUOS_TASK;
+        }
+        luos_tasks_cursor.position++;
+    }
+    *container_index = luos_tasks_cursor.container_index;
+    return luos_tasks_cursor.task_id;
+}
 
 /*******************************************************************************
  * Functions --> Luos tasks find and consume
  ******************************************************************************/
 
 /******************************************************************************
- * @brief Pull a message allocated to a specific module
+ * @brief Pull the oldest message allocated to a specific module
  * @param target_module : The module concerned by this message
  * @param returned_msg : The message pointer.
  * @return error_return_t
  ******************************************************************************/
 error_return_t MsgAlloc_PullMsg(ll_container_t *target_module, msg_t **returned_msg)
 {
-    //find the oldest message allocated to this module
-    for (uint16_t i = 0; i < luos_tasks_stack_id; i++)
+    uint16_t container_index = MsgAlloc_GetContainerIndex(target_module);
+    // The oldest message allocated to this module is the first of its FIFO...
+    uint16_t luos_task_id = container_tasks[container_index].first;
+    // ...or the oldest shared task it didn't consume yet.
+    uint16_t shared_task_id = shared_tasks_first[container_index];
+    if ((shared_task_id != NO_LUOS_TASK) && ((luos_task_id == NO_LUOS_TASK) || ((int16_t)(luos_tasks[shared_task_id].arrival - luos_tasks[luos_task_id].arrival) < 0)))
+    {
+        luos_task_id = shared_task_id;
+    }
+    if (luos_task_id != NO_LUOS_TASK)
     {
-        if (luos_tasks[i].ll_container_pt == target_module)
+        if (MsgAlloc_IsOverwritten(luos_tasks[luos_task_id].vpos))
         {
-            *returned_msg = luos_tasks[i].msg_pt;
-
-            // Clear the slot by sliding others to the left on it
-            used_msg = *returned_msg;
-            MsgAlloc_ClearLuosTask(i);
-            return SUCCEED;
+            // This message have been overwritten by reception, remove it and look at the next one
+            MsgAlloc_DropLuosTask(luos_task_id);
+            MSGALLOC_COUNT_DROP(mem_stat->buffer_evict_drop);
+            return MsgAlloc_PullMsg(target_module, returned_msg);
         }
+        *returned_msg = luos_tasks[luos_task_id].msg_pt;
+        used_msg = *returned_msg;
+        used_vpos = luos_tasks[luos_task_id].vpos;
+        MsgAlloc_ConsumeLuosTask(luos_task_id, container_index);
+        MsgAlloc_UpdateRelease();
+        return SUCCEED;
     }
     // At this point we don't find any message for this module
     return FAILED;
 }
+/******************************************************************************
+ * @brief Pull and pin the oldest messages allocated to a specific module in one pass
+ * @param target_module : The module concerned by these messages
+ * @param returned_msgs : Table filled with the message pointers in arrival order.
+ * @param max_nbr : Size of the returned_msgs table
+ * @return number of pulled messages, they are pinned as a single batch until MsgAlloc_UnpinMsgBatch
+ * @warning Pulling again before the release add the new messages to the pending batch.
+ ******************************************************************************/
+uint16_t MsgAlloc_PullMsgBatch(ll_container_t *target_module, msg_t **returned_msgs, uint16_t max_nbr)
+{
+    uint16_t container_index = MsgAlloc_GetContainerIndex(target_module);
+    container_mask_t container_bit = (container_mask_t)1 << container_index;
+    uint16_t nbr = 0;
+    // Remove the oldest luos_tasks if their messages have been overwritten
+    MsgAlloc_ClearOverwrittenLuosTasks();
+    // Merge the FIFO of this module and the shared tasks it didn't consume yet in arrival order
+    uint16_t luos_task_id = container_tasks[container_index].first;
+    uint16_t shared_task_id = shared_tasks_first[container_index];
+    while (nbr < max_nbr)
+    {
+        while ((shared_task_id != NO_LUOS_TASK) && !(luos_tasks[shared_task_id].container_mask & container_bit))
+        {
+            shared_task_id = luos_tasks[shared_task_id].container_next;
+        }
+        uint16_t task_id = luos_task_id;
+        if ((shared_task_id != NO_LUOS_TASK) && ((luos_task_id == NO_LUOS_TASK) || ((int16_t)(luos_tasks[shared_task_id].arrival - luos_tasks[luos_task_id].arrival) < 0)))
+        {
+            task_id = shared_task_id;
+            shared_task_id = luos_tasks[shared_task_id].container_next;
+        }
+        else if (luos_task_id != NO_LUOS_TASK)
+        {
+            luos_task_id = luos_tasks[luos_task_id].container_next;
+        }
+        else
+        {
+            // There is no more message for this module
+            break;
+        }
+        msg_t *msg = luos_tasks[task_id].msg_pt;
+        uint32_t vpos = luos_tasks[task_id].vpos;
+        MsgAlloc_ConsumeLuosTask(task_id, container_index);
+        if (MsgAlloc_PinBatch(container_index, msg, vpos) == FAILED)
+        {
+            // This message have been overwritten by reception
+            MSGALLOC_COUNT_DROP(mem_stat->buffer_evict_drop);
+            MsgAlloc_CountContainerDrop(container_index);
+            continue;
+        }
+        returned_msgs[nbr++] = msg;
+    }
+    MsgAlloc_UpdateRelease();
+    return nbr;
+}
 /******************************************************************************
  * @brief Pull a message allocated to a specific luos task
- * @param luos_task_id : Id of the allocator luos task
+ * @param luos_task_id : Position of the task in the interpretation order (see MsgAlloc_FindLuosTask)
  * @param returned_msg : The message pointer.
  * @return error_return_t
  ******************************************************************************/
 error_return_t MsgAlloc_PullMsgFromLuosTask(uint16_t luos_task_id, msg_t **returned_msg)
 {
-    //find the oldest message allocated to this module
-    if (luos_task_id < luos_tasks_stack_id)
+    uint16_t container_index;
+    uint16_t task_id = MsgAlloc_FindLuosTask(luos_task_id, &container_index);
+    if (task_id != NO_LUOS_TASK)
     {
-        *returned_msg = luos_tasks[luos_task_id].msg_pt;
-
-        // Clear the slot by sliding others to the left on it
+        if (MsgAlloc_IsOverwritten(luos_tasks[task_id].vpos))
+        {
+            // This message have been overwritten by reception, remove it
+            MsgAlloc_DropLuosTask(task_id);
+            MSGALLOC_COUNT_DROP(mem_stat->buffer_evict_drop);
+            return FAILED;
+        }
+        *returned_msg = luos_tasks[task_id].msg_pt;
         used_msg = *returned_msg;
-        MsgAlloc_ClearLuosTask(luos_task_id);
+        used_vpos = luos_tasks[task_id].vpos;
+        // The next task take the position of this one once it is consumed
+        luos_task_cursor_t next_cursor = luos_tasks_cursor;
+        error_return_t next_found = MsgAlloc_NextLuosTask(&next_cursor);
+        MsgAlloc_ConsumeLuosTask(task_id, container_index);
+        if (next_found == SUCCEED)
+        {
+            luos_tasks_cursor = next_cursor;
+        }
+        MsgAlloc_UpdateRelease();
         return SUCCEED;
     }
     // At this point we don't find any message for this module
@@ -548,89 +2022,101 @@ error_return_t MsgAlloc_PullMsgFromLuosTask(uint16_t luos_task_id, msg_t **retur
 /******************************************************************************
  * @brief get back the module who received the oldest message 
  * @param allocated_module : Return the module concerned by the oldest message
- * @param luos_task_id : Id of the allocator slot
+ * @param luos_task_id : Position of the task in the interpretation order (see MsgAlloc_FindLuosTask)
  * @return error_return_t : Fail is there is no more message available.
  ******************************************************************************/
 error_return_t MsgAlloc_LookAtLuosTask(uint16_t luos_task_id, ll_container_t **allocated_module)
 {
-    if (luos_task_id < luos_tasks_stack_id)
+    uint16_t container_index;
+    error_return_t error = FAILED;
+    // Remove the oldest luos_tasks if their messages have been overwritten
+    MsgAlloc_ClearOverwrittenLuosTasks();
+    if (MsgAlloc_FindLuosTask(luos_task_id, &container_index) != NO_LUOS_TASK)
     {
-        *allocated_module = luos_tasks[luos_task_id].ll_container_pt;
-        return SUCCEED;
+        *allocated_module = (ll_container_t *)&ctx.ll_container_table[container_index];
+        error = SUCCEED;
     }
-    return FAILED;
+    return error;
 }
 /******************************************************************************
  * @brief get back a specific slot message command
- * @param luos_task_id : Id of the allocator slot
+ * @param luos_task_id : Position of the task in the interpretation order (see MsgAlloc_FindLuosTask)
  * @param cmd : The pointer filled with the cmd value.
  * @return error_return_t : Fail is there is no more message available.
  ******************************************************************************/
 error_return_t MsgAlloc_GetLuosTaskCmd(uint16_t luos_task_id, uint8_t *cmd)
 {
-    if (luos_task_id < luos_tasks_stack_id)
+    uint16_t container_index;
+    error_return_t error = FAILED;
+    uint16_t task_id = MsgAlloc_FindLuosTask(luos_task_id, &container_index);
+    if (task_id != NO_LUOS_TASK)
     {
-        *cmd = luos_tasks[luos_task_id].msg_pt->header.cmd;
-        return SUCCEED;
+        *cmd = luos_tasks[task_id].msg_pt->header.cmd;
+        error = SUCCEED;
     }
-    return FAILED;
+    return error;
 }
 /******************************************************************************
- * @brief get back a specific slot message command
- * @param luos_task_id : Id of the allocator slot
- * @param cmd : The pointer filled with the cmd value.
+ * @brief get back a specific slot message source id
+ * @param luos_task_id : Position of the task in the interpretation order (see MsgAlloc_FindLuosTask)
+ * @param source_id : The pointer filled with the source id value.
  * @return error_return_t : Fail is there is no more message available.
  ******************************************************************************/
 error_return_t MsgAlloc_GetLuosTaskSourceId(uint16_t luos_task_id, uint16_t *source_id)
 {
-    if (luos_task_id < luos_tasks_stack_id)
+    uint16_t container_index;
+    error_return_t error = FAILED;
+    uint16_t task_id = MsgAlloc_FindLuosTask(luos_task_id, &container_index);
+    if (task_id != NO_LUOS_TASK)
     {
-        *source_id = luos_tasks[luos_task_id].msg_pt->header.source;
-        return SUCCEED;
+        *source_id = luos_tasks[task_id].msg_pt->header.source;
+        error = SUCCEED;
     }
-    return FAILED;
+    return error;
 }
 /******************************************************************************
- * @brief get back a specific slot message command
- * @param luos_task_id : Id of the allocator slot
+ * @brief get back a specific slot message size
+ * @param luos_task_id : Position of the task in the interpretation order (see MsgAlloc_FindLuosTask)
  * @param size : The pointer filled with the size value.
  * @return error_return_t : Fail is there is no more message available.
  ******************************************************************************/
 error_return_t MsgAlloc_GetLuosTaskSize(uint16_t luos_task_id, uint16_t *size)
 {
-    if (luos_task_id < luos_tasks_stack_id)
+    uint16_t container_index;
+    error_return_t error = FAILED;
+    uint16_t task_id = MsgAlloc_FindLuosTask(luos_task_id, &container_index);
+    if (task_id != NO_LUOS_TASK)
     {
-        *size = luos_tasks[luos_task_id].msg_pt->header.size;
-        return SUCCEED;
+        *size = luos_tasks[task_id].msg_pt->header.size;
+        error = SUCCEED;
     }
-    return FAILED;
+    return error;
 }
 /******************************************************************************
- * @brief return the number of allocated messages
+ * @brief return the number of messages still to be consumed by containers
  * @param None
  * @return the number of messages
  ******************************************************************************/
 uint16_t MsgAlloc_LuosTasksNbr(void)
 {
-    return (uint16_t)luos_tasks_stack_id;
+    return (uint16_t)luos_tasks_delivery_nbr;
 }
 /******************************************************************************
- * @brief return the number of allocated messages
- * @param None
- * @return the number of messages
+ * @brief remove all the luos tasks linked to a message
+ * @param msg : The message to remove from luos tasks
+ * @return None
  ******************************************************************************/
 void MsgAlloc_ClearMsgFromLuosTasks(msg_t *msg)
 {
-    uint16_t id = 0;
-    while (id < luos_tasks_stack_id)
+    uint16_t luos_task_id = luos_tasks_order.first;
+    while (luos_task_id != NO_LUOS_TASK)
     {
-        if (luos_tasks[id].msg_pt == msg)
-        {
-            MsgAlloc_ClearLuosTask(id);
-        }
-        else
+        uint16_t next_task_id = luos_tasks[luos_task_id].next;
+        if (luos_tasks[luos_task_id].msg_pt == msg)
         {
-            id++;
+            MsgAlloc_ClearLuosTask(luos_task_id);
         }
+        luos_task_id = next_task_id;
     }
+    MsgAlloc_UpdateRelease();
 }
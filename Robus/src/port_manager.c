@@ -8,7 +8,9 @@
 #include "port_manager.h"
 #include "transmission.h"
 #include "context.h"
+#include "target.h"
 #include "luos_hal.h"
+#include "timing.h"
 
 /*******************************************************************************
  * Definitions
@@ -40,6 +42,7 @@ void PortMng_Init(void)
     {
         ctx.ll_container_table[i].id = DEFAULTID;
     }
+    Trgt_UpdateFilters();
     // Reinit port table
     for (uint8_t port = 0; port < NBR_PORT; port++)
     {
@@ -84,12 +87,15 @@ uint8_t PortMng_PokePort(uint8_t PortNbr)
     // push the ptp line
     LuosHAL_PushPTP(PortNbr);
     // wait a little just to be sure everyone can read it
-    uint32_t start_tick = LuosHAL_GetSystick();
-    while (LuosHAL_GetSystick() - start_tick < 2)
+    deadline_t release_deadline;
+    deadline_t read_deadline;
+    Timing_SetDeadline(&release_deadline, 2000);
+    Timing_SetDeadline(&read_deadline, 3000);
+    while (!Timing_IsExpired(&release_deadline))
         ;
     // release the ptp line
     LuosHAL_SetPTPDefaultState(PortNbr);
-    while (LuosHAL_GetSystick() - start_tick < 3)
+    while (!Timing_IsExpired(&read_deadline))
         ;
     // Save port as empty by default
     ctx.node.port_table[PortNbr] = 0xFFFF;
@@ -12,6 +12,8 @@
 #include "target.h"
 #include "transmission.h"
 #include "msg_alloc.h"
+#include "crc.h"
+#include "aggregation.h"
 
 /*******************************************************************************
  * Definitions
@@ -21,12 +23,20 @@
 #endif
 
 #define COLLISION_DETECTION_NUMBER 4
+// saturated counter increment, working for any unsigned counter size
+#define RECEP_COUNT(counter) \
+    if (++counter == 0)          \
+    {                            \
+        counter--;               \
+    }
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 uint16_t data_count = 0;
 uint16_t data_size = 0;
 uint16_t crc_val = 0;
+static uint8_t discard_msg = false; /*!< true when a filtered message is received only to be acknowledged. */
+static uint8_t discard_crc[2];      /*!< CRC of the discarded message. */
 
 /*******************************************************************************
  * Function
@@ -43,6 +53,65 @@ void Recep_Init(void)
     ctx.rx.status.unmap = 0;
     ctx.rx.callback = Recep_GetHeader;
 }
+/******************************************************************************
+ * @brief Process a block of received bytes (DMA or idle line reception)
+ * @param buf : received bytes
+ * @param len : number of bytes
+ * @return None
+ ******************************************************************************/
+void Recep_ProcessBlock(const uint8_t *buf, uint16_t len)
+{
+    uint16_t nbr;
+    while (len > 0)
+    {
+        if ((ctx.rx.callback == Recep_GetData) && (data_count < data_size))
+        {
+            // Copy all the data bytes available at once, the CRC bytes go to the callback
+            nbr = data_size - data_count;
+            if (nbr > len)
+            {
+                nbr = len;
+            }
+            MsgAlloc_SetDataBlock(buf, nbr);
+            crc_val = Crc_Update(crc_val, buf, nbr);
+            data_count += nbr;
+        }
+        else if ((ctx.rx.callback == Recep_GetDiscard) && (data_count < data_size))
+        {
+            // Only compute the CRC of the data of the message to discard
+            nbr = data_size - data_count;
+            if (nbr > len)
+            {
+                nbr = len;
+            }
+            crc_val = Crc_Update(crc_val, buf, nbr);
+            data_count += nbr;
+        }
+        else if ((ctx.rx.callback == Recep_GetNak) && (data_count <= data_size))
+        {
+            // Skip the data of the message to NAK
+            nbr = data_size + 1 - data_count;
+            if (nbr > len)
+            {
+                nbr = len;
+            }
+            data_count += nbr;
+        }
+        else if (ctx.rx.callback == Recep_Drop)
+        {
+            // Nothing more to catch until the end of this message
+            return;
+        }
+        else
+        {
+            // Header, CRC, collision and ack bytes keep the byte per byte state machine
+            ctx.rx.callback((volatile uint8_t *)buf);
+            nbr = 1;
+        }
+        buf += nbr;
+        len -= nbr;
+    }
+}
 /******************************************************************************
  * @brief Callback to get a complete header
  * @param data come from RX
@@ -59,12 +128,30 @@ void Recep_GetHeader(volatile uint8_t *data)
     {
     case 1: //reset CRC computation
         ctx.tx.lock = true;
-        crc_val = 0xFFFF;
+        crc_val = CRC_INIT_VAL;
+        discard_msg = false;
         break;
 
     case 3: //check if message is for the node
         if(Recep_NodeConcerned((header_t *)&current_msg->header) == false)
         {
+            RECEP_COUNT(ctx.stats.filter_drop_nbr);
+            MsgAlloc_ValidHeader(false, data_size);
+            ctx.rx.callback = Recep_Drop;
+            return;
+        }
+        break;
+
+    case 5: //check if the cmd is accepted by the concerned containers
+        if (Recep_CmdConcerned((header_t *)&current_msg->header) == false)
+        {
+            RECEP_COUNT(ctx.stats.filter_drop_nbr);
+            if ((current_msg->header.target_mode == IDACK) || (current_msg->header.target_mode == NODEIDACK))
+            {
+                // The sender wait for an ACK, receive this message without saving it
+                discard_msg = true;
+                break;
+            }
             MsgAlloc_ValidHeader(false, data_size);
             ctx.rx.callback = Recep_Drop;
             return;
@@ -86,9 +173,9 @@ void Recep_GetHeader(volatile uint8_t *data)
         // Switch state machiine to data reception
         ctx.rx.callback = Recep_GetData;
         // Cap size for big messages
-        if (current_msg->header.size > MAX_DATA_MSG_SIZE)
+        if (current_msg->header.size > MAX_FRAME_DATA_SIZE)
         {
-            data_size = MAX_DATA_MSG_SIZE;
+            data_size = MAX_FRAME_DATA_SIZE;
         }
         else
         {
@@ -97,13 +184,30 @@ void Recep_GetHeader(volatile uint8_t *data)
 
         if ((ctx.rx.status.rx_framing_error == false))
         {
-            if (data_size)
+            if (discard_msg == true)
             {
-                MsgAlloc_ValidHeader(true, data_size);
+                // Release the header space, the data will only be used to compute the CRC
+                MsgAlloc_ValidHeader(false, data_size);
+                ctx.rx.callback = Recep_GetDiscard;
+            }
+            else if (MsgAlloc_ValidHeader(true, data_size) == FAILED)
+            {
+                // There is no space to receive this message
+                if ((current_msg->header.target_mode == IDACK) || (current_msg->header.target_mode == NODEIDACK))
+                {
+                    // NAK it at the end allowing the sender to retry later
+                    ctx.rx.callback = Recep_GetNak;
+                }
+                else
+                {
+                    ctx.rx.callback = Recep_Drop;
+                }
+                return;
             }
         }
         else
         {
+            RECEP_COUNT(ctx.stats.framing_error_nbr);
             MsgAlloc_ValidHeader(false, data_size);
             ctx.rx.callback = Recep_Drop;
             return;
@@ -113,7 +217,7 @@ void Recep_GetHeader(volatile uint8_t *data)
     default:
         break;
     }
-    LuosHAL_ComputeCRC((uint8_t *)data, (uint8_t *)&crc_val);
+    crc_val = Crc_Update(crc_val, (const uint8_t *)data, 1);
 }
 /******************************************************************************
  * @brief Callback to get a complete data
@@ -126,7 +230,7 @@ void Recep_GetData(volatile uint8_t *data)
     if (data_count < data_size)
     {
         // Continue CRC computation until the end of data
-        LuosHAL_ComputeCRC((uint8_t *)data, (uint8_t *)&crc_val);
+        crc_val = Crc_Update(crc_val, (const uint8_t *)data, 1);
     }
     else if(data_count > data_size)
     {
@@ -134,6 +238,7 @@ void Recep_GetData(volatile uint8_t *data)
                        ((uint16_t)current_msg->data[data_size + 1] << 8);
         if (crc == crc_val)
         {
+            RECEP_COUNT(ctx.stats.rx_frame_nbr);
             if (((current_msg->header.target_mode == IDACK) || (current_msg->header.target_mode == NODEIDACK)))
             {
                 Transmit_SendAck();
@@ -153,6 +258,7 @@ void Recep_GetData(volatile uint8_t *data)
         }
         else
         {
+            RECEP_COUNT(ctx.stats.crc_error_nbr);
             ctx.rx.status.rx_error = TRUE;
             if ((current_msg->header.target_mode == IDACK) || (current_msg->header.target_mode == NODEIDACK))
             {
@@ -165,6 +271,55 @@ void Recep_GetData(volatile uint8_t *data)
     }
     data_count++;
 }
+/******************************************************************************
+ * @brief Callback to receive a filtered message without saving it and ACK it at the end
+ * @param data come from RX
+ * @return None
+ ******************************************************************************/
+void Recep_GetDiscard(volatile uint8_t *data)
+{
+    if (data_count < data_size)
+    {
+        crc_val = Crc_Update(crc_val, (const uint8_t *)data, 1);
+    }
+    else
+    {
+        discard_crc[data_count - data_size] = *data;
+        if (data_count > data_size)
+        {
+            if ((((uint16_t)discard_crc[0]) | ((uint16_t)discard_crc[1] << 8)) == crc_val)
+            {
+                RECEP_COUNT(ctx.stats.rx_frame_nbr);
+            }
+            else
+            {
+                RECEP_COUNT(ctx.stats.crc_error_nbr);
+                ctx.rx.status.rx_error = TRUE;
+            }
+            Transmit_SendAck();
+            ctx.rx.callback = Recep_Drop;
+            return;
+        }
+    }
+    data_count++;
+}
+/******************************************************************************
+ * @brief Callback to drop a message that can't be saved and NAK it at the end
+ * @param data come from RX
+ * @return None
+ ******************************************************************************/
+void Recep_GetNak(volatile uint8_t *data)
+{
+    (void)data;
+    if (data_count > data_size)
+    {
+        ctx.rx.status.rx_error = TRUE;
+        Transmit_SendAck();
+        ctx.rx.callback = Recep_Drop;
+        return;
+    }
+    data_count++;
+}
 /******************************************************************************
  * @brief Callback to get a collision beetween RX and Tx
  * @param data come from RX
@@ -177,6 +332,7 @@ void Recep_GetCollision(volatile uint8_t *data)
     {
         //data dont match, or we don't start to send, there is a collision
         ctx.tx.collision = TRUE;
+        RECEP_COUNT(ctx.stats.collision_nbr);
         //Stop TX trying to save input datas
         LuosHAL_SetTxState(false);
         // switch to get header.
@@ -190,6 +346,7 @@ void Recep_GetCollision(volatile uint8_t *data)
         {
             if(Recep_NodeConcerned((header_t *)&current_msg->header) == false)
             {
+                RECEP_COUNT(ctx.stats.filter_drop_nbr);
                 MsgAlloc_ValidHeader(false, data_size);
                 ctx.rx.callback = Recep_Drop;
                 return;
@@ -206,7 +363,7 @@ void Recep_GetCollision(volatile uint8_t *data)
             return;
         }
     }
-    LuosHAL_ComputeCRC((uint8_t *)data, (uint8_t *)&crc_val);
+    crc_val = Crc_Update(crc_val, (const uint8_t *)data, 1);
 }
 /******************************************************************************
  * @brief Callback to get a complete header
@@ -227,6 +384,7 @@ void Recep_Timeout(void)
     if ((ctx.rx.callback != Recep_GetHeader)&&(ctx.rx.callback != Recep_Drop))
     {
         ctx.rx.status.rx_timeout = TRUE;
+        RECEP_COUNT(ctx.stats.timeout_nbr);
     }
     MsgAlloc_InvalidMsg();
     ctx.tx.lock = false;
@@ -240,7 +398,7 @@ void Recep_Timeout(void)
 void Recep_Reset(void)
 {
     data_count = 0;
-    crc_val = 0xFFFF;
+    crc_val = CRC_INIT_VAL;
     ctx.rx.status.rx_framing_error = false;
     LuosHAL_SetIrqState(false);
     ctx.rx.callback = Recep_GetHeader;
@@ -265,25 +423,22 @@ void Recep_CatchAck(volatile uint8_t *data)
 ll_container_t *Recep_GetConcernedLLContainer(header_t *header)
 {
     uint16_t i = 0;
+    container_mask_t container_mask = 0;
     // Find if we are concerned by this message.
     switch (header->target_mode)
     {
     case IDACK:
     case ID:
-        // Check all ll_container id
-        for (i = 0; i < ctx.ll_container_number; i++)
-        {
-            if ((header->target == ctx.ll_container_table[i].id))
-            {
-                return (ll_container_t *)&ctx.ll_container_table[i];
-            }
-        }
+        return Trgt_GetContainerFromId(header->target);
         break;
     case TYPE:
-        // Check all ll_container type
+        return Trgt_GetContainerFromType(header->target);
+        break;
+    case MULTICAST:
+        container_mask = Trgt_GetMulticastMask(header->target);
         for (i = 0; i < ctx.ll_container_number; i++)
         {
-            if (header->target == ctx.ll_container_table[i].type)
+            if (container_mask & ((container_mask_t)1 << i))
             {
                 return (ll_container_t *)&ctx.ll_container_table[i];
             }
@@ -294,7 +449,6 @@ ll_container_t *Recep_GetConcernedLLContainer(header_t *header)
     case NODEID:
         return (ll_container_t *)&ctx.ll_container_table[0];
         break;
-    case MULTICAST: // For now Multicast is disabled
     default:
         return NULL;
         break;
@@ -308,31 +462,16 @@ ll_container_t *Recep_GetConcernedLLContainer(header_t *header)
  ******************************************************************************/
 uint8_t Recep_NodeConcerned(header_t *header)
 {
-    uint16_t i = 0;
     // Find if we are concerned by this message.
     switch (header->target_mode)
     {
     case IDACK:
         ctx.rx.status.rx_error = FALSE;
     case ID:
-        // Check all ll_container id
-        for (i = 0; i < ctx.ll_container_number; i++)
-        {
-            if ((header->target == ctx.ll_container_table[i].id))
-            {
-                return true;
-            }
-        }
+        return Trgt_IdConcerned(header->target);
         break;
     case TYPE:
-        // Check all ll_container type
-        for (i = 0; i < ctx.ll_container_number; i++)
-        {
-            if (header->target == ctx.ll_container_table[i].type)
-            {
-                return true;
-            }
-        }
+        return (Trgt_GetTypeMask(header->target) != 0);
         break;
     case BROADCAST:
         if (header->target == BROADCAST_VAL)
@@ -355,13 +494,60 @@ uint8_t Recep_NodeConcerned(header_t *header)
             }
         }
         break;
-    case MULTICAST: // For now Multicast is disabled
+    case MULTICAST:
+        return Trgt_MulticastConcerned(header->target);
+        break;
     default:
         return false;
         break;
     }
     return false;
 }
+/******************************************************************************
+ * @brief Check if the containers concerned by a message accept its cmd
+ * @param header of message
+ * @return true if the message is wanted
+ ******************************************************************************/
+uint8_t Recep_CmdConcerned(header_t *header)
+{
+    ll_container_t *ll_container = NULL;
+    container_mask_t container_mask = 0;
+    switch (header->target_mode)
+    {
+    case IDACK:
+    case ID:
+        ll_container = Trgt_GetContainerFromId(header->target);
+        break;
+    case TYPE:
+        ll_container = Trgt_GetContainerFromType(header->target);
+        break;
+    case MULTICAST:
+        return (Trgt_CmdFilterMask(Trgt_GetMulticastMask(header->target), header->cmd) != 0);
+        break;
+    case NODEIDACK:
+        if (header->target == DEFAULTID)
+        {
+            // Messages on default ID are for the first container
+            ll_container = (ll_container_t *)&ctx.ll_container_table[0];
+            break;
+        }
+        for (uint16_t i = 0; i < ctx.ll_container_number; i++)
+        {
+            container_mask |= ((container_mask_t)1 << i);
+        }
+        return (Trgt_CmdFilterMask(container_mask, header->cmd) != 0);
+        break;
+    default:
+        // The others concern all containers, they are filtered when creating luos tasks
+        return true;
+        break;
+    }
+    if (ll_container == NULL)
+    {
+        return true;
+    }
+    return Trgt_CmdAccepted(ll_container, header->cmd);
+}
 /******************************************************************************
  * @brief Parse msg to find all modules concerned and create
  * @param msg pointer
@@ -370,49 +556,48 @@ uint8_t Recep_NodeConcerned(header_t *header)
 void Recep_InterpretMsgProtocol(msg_t *msg)
 {
     uint16_t i = 0;
+    container_mask_t container_mask = 0;
+    ll_container_t *ll_container;
+    if (msg->header.cmd == AGGREGATE)
+    {
+        // This frame contain several messages, interpret them one by one
+        Aggr_Unpack(msg);
+        return;
+    }
     // Find if we are concerned by this message.
     switch (msg->header.target_mode)
     {
     case IDACK:
     case ID:
-        // Check all ll_container id
-        for (i = 0; i < ctx.ll_container_number; i++)
+        ll_container = Trgt_GetContainerFromId(msg->header.target);
+        if ((ll_container != NULL) && Trgt_CmdAccepted(ll_container, msg->header.cmd))
         {
-            if (msg->header.target == ctx.ll_container_table[i].id)
-            {
-                MsgAlloc_LuosTaskAlloc((ll_container_t *)&ctx.ll_container_table[i], msg);
-                return;
-            }
+            MsgAlloc_LuosTaskAlloc(ll_container, msg);
         }
+        return;
         break;
     case TYPE:
-        // Check all ll_container type
-        for (i = 0; i < ctx.ll_container_number; i++)
+        ll_container = Trgt_GetContainerFromType(msg->header.target);
+        if ((ll_container != NULL) && Trgt_CmdAccepted(ll_container, msg->header.cmd))
         {
-            if (msg->header.target == ctx.ll_container_table[i].type)
-            {
-                MsgAlloc_LuosTaskAlloc((ll_container_t *)&ctx.ll_container_table[i], msg);
-                return;
-            }
+            MsgAlloc_LuosTaskAlloc(ll_container, msg);
         }
+        return;
         break;
     case BROADCAST:
+        // Create only one task shared by all containers
         for (i = 0; i < ctx.ll_container_number; i++)
         {
-            MsgAlloc_LuosTaskAlloc((ll_container_t *)&ctx.ll_container_table[i], msg);
+            container_mask |= ((container_mask_t)1 << i);
         }
+        MsgAlloc_LuosSharedTaskAlloc(Trgt_CmdFilterMask(container_mask, msg->header.cmd), msg);
         return;
         break;
     case MULTICAST:
-        for (i = 0; i < ctx.ll_container_number; i++)
-        {
-            if (Trgt_MulticastTargetBank((ll_container_t *)&ctx.ll_container_table[i], msg->header.target))
-            {
-                //TODO manage multiple slave concerned
-                MsgAlloc_LuosTaskAlloc((ll_container_t *)&ctx.ll_container_table[i], msg);
-                return;
-            }
-        }
+        // Create only one task shared by all the containers of this group
+        container_mask = Trgt_GetMulticastMask(msg->header.target);
+        MsgAlloc_LuosSharedTaskAlloc(Trgt_CmdFilterMask(container_mask, msg->header.cmd), msg);
+        return;
         break;
     case NODEIDACK:
     case NODEID:
@@ -421,10 +606,12 @@ void Recep_InterpretMsgProtocol(msg_t *msg)
             MsgAlloc_LuosTaskAlloc((ll_container_t *)&ctx.ll_container_table[0], msg);
             return;
         }
+        // Create only one task shared by all containers
         for (i = 0; i < ctx.ll_container_number; i++)
         {
-            MsgAlloc_LuosTaskAlloc((ll_container_t *)&ctx.ll_container_table[i], msg);
+            container_mask |= ((container_mask_t)1 << i);
         }
+        MsgAlloc_LuosSharedTaskAlloc(Trgt_CmdFilterMask(container_mask, msg->header.cmd), msg);
         return;
         break;
     default:
@@ -14,6 +14,11 @@
 #include "context.h"
 #include "luos_hal.h"
 #include "msg_alloc.h"
+#include "crc.h"
+#include "timing.h"
+#include "baudrate.h"
+#include "aggregation.h"
+#include "target.h"
 #include "luos_utils.h"
 
 /*******************************************************************************
@@ -34,6 +39,8 @@ typedef struct __attribute__((__packed__))
 } node_bootstrap_t;
 
 static error_return_t Robus_MsgHandler(msg_t *input);
+static error_return_t Robus_CatchHandler(msg_t *input);
+static error_return_t Robus_QueueMsg(ll_container_t *ll_container, msg_t *msg, TX_CB tx_cb, uint16_t *tx_id, uint8_t keep_msg);
 static error_return_t Robus_DetectNextNodes(ll_container_t *ll_container);
 static error_return_t Robus_ResetNetworkDetection(ll_container_t *ll_container);
 /*******************************************************************************
@@ -41,8 +48,12 @@ static error_return_t Robus_ResetNetworkDetection(ll_container_t *ll_container);
  ******************************************************************************/
 // Creation of the robus context. This variable is used in all files of this lib.
 volatile context_t ctx;
-uint32_t baudrate; /*!< System current baudrate. */
 volatile uint16_t last_node = 0;
+// Message waited by a blocking loop, caught before the luos tasks creation
+static ll_container_t *catch_ll_container = NULL;
+static uint8_t catch_cmd = 0;
+static msg_t *catch_msg = NULL;
+static volatile uint8_t catch_done = false;
 
 /*******************************************************************************
  * Function
@@ -57,6 +68,8 @@ void Robus_Init(memory_stats_t *memory_stats)
 {
     // Init the number of created  virtual container.
     ctx.ll_container_number = 0;
+    // Clear target filters
+    Trgt_Init();
     // Set default container id. This id is a void id used if no container is created.
     ctx.node.node_id = DEFAULTID;
     // By default node are not certified.
@@ -64,17 +77,26 @@ void Robus_Init(memory_stats_t *memory_stats)
     // no transmission lock
     ctx.tx.lock = FALSE;
     // Save luos baudrate
-    baudrate = DEFAULTBAUDRATE;
+    Baud_Init();
+    // Clear reception statistics
+    memset((void *)&ctx.stats, 0, sizeof(robus_stats_t));
     
     // Init reception
     Recep_Init();
 
+    // Init transmission queue
+    Transmit_Init();
+    Aggr_Init();
+
     // Clear message allocation buffer table
     MsgAlloc_Init(memory_stats);
 
     // Init hal
     LuosHAL_Init();
 
+    // Init us clock and delays
+    Timing_Init();
+
     // init detection structure
     PortMng_Init();
 
@@ -89,19 +111,24 @@ void Robus_Init(memory_stats_t *memory_stats)
  ******************************************************************************/
 void Robus_Loop(void)
 {
+    // Go back to the previous baudrate if a tested one is not committed
+    Baud_Loop();
     // Execute message allocation tasks
     MsgAlloc_loop();
     // Interpreat received messages and create luos task for it.
     msg_t *msg = NULL;
     while (MsgAlloc_PullMsgToInterpret(&msg) == SUCCEED)
     {
-        // Check if this message is a protocole one
-        if (Robus_MsgHandler(msg) == FAILED)
+        // Check if this message is a protocole one or a waited one
+        if ((Robus_MsgHandler(msg) == FAILED) && (Robus_CatchHandler(msg) == FAILED))
         {
             // If not create luos tasks.
             Recep_InterpretMsgProtocol(msg);
         }
     }
+    // Send queued messages
+    Aggr_Loop();
+    Transmit_Loop();
 }
 /******************************************************************************
  * @brief crete a container in route table
@@ -116,8 +143,22 @@ ll_container_t *Robus_ContainerCreate(uint16_t type)
     ctx.ll_container_table[ctx.ll_container_number].id = DEFAULTID;
     // Initialize dead container detection
     ctx.ll_container_table[ctx.ll_container_number].dead_container_spotted = 0;
+    // By default keep all the received messages
+    ctx.ll_container_table[ctx.ll_container_number].coalescing = false;
+    // By default there is no quota
+    ctx.ll_container_table[ctx.ll_container_number].quota_min_task = 0;
+    ctx.ll_container_table[ctx.ll_container_number].quota_max_task = 0;
+    ctx.ll_container_table[ctx.ll_container_number].quota_max_byte = 0;
+    ctx.ll_container_table[ctx.ll_container_number].priority = NORMAL_PRIORITY;
+    // By default the container is not in any multicast group
+    ctx.ll_container_table[ctx.ll_container_number].max_multicast_target = 0;
+    // By default the container accept all cmds
+    memset((void *)ctx.ll_container_table[ctx.ll_container_number].cmd_filter, 0xFF, sizeof(ctx.ll_container_table[0].cmd_filter));
+    ctx.ll_container_number++;
+    // Add this container to the reception filters
+    Trgt_UpdateFilters();
     // Return the freshly initialized ll_container pointer.
-    return (ll_container_t *)&ctx.ll_container_table[ctx.ll_container_number++];
+    return (ll_container_t *)&ctx.ll_container_table[ctx.ll_container_number - 1];
 }
 /******************************************************************************
  * @brief clear container list in route table
@@ -130,22 +171,88 @@ void Robus_ContainersClear(void)
     memset((void *)ctx.ll_container_table, 0, sizeof(ll_container_t) * MAX_CONTAINER_NUMBER);
     // Reset the number of created containers
     ctx.ll_container_number = 0;
+    Trgt_UpdateFilters();
 }
 /******************************************************************************
- * @brief Send Msg to a container
+ * @brief Send Msg to a container and wait the end of its transmission
  * @param container to send
  * @param msg to send
  * @return Error
  ******************************************************************************/
 error_return_t Robus_SendMsg(ll_container_t *ll_container, msg_t *msg)
+{
+    uint16_t tx_id;
+    tx_status_t status;
+    // Keep the order with the pending aggregated messages, send them first
+    while (Aggr_Flush() == FAILED)
+    {
+        Transmit_Loop();
+    }
+    // Wait for a free space into the transmission queue
+    while (Transmit_IsFull())
+    {
+        Transmit_Loop();
+    }
+    // msg stay valid until the end of this function, it is sent without copy
+    if (Robus_QueueMsg(ll_container, msg, NULL, &tx_id, true) == FAILED)
+    {
+        return FAILED;
+    }
+    // Send the queue until the end of this message transmission
+    do
+    {
+        Transmit_Loop();
+        status = Transmit_GetStatus(tx_id);
+    } while (status == TX_PENDING);
+    if (status == TX_SUCCEED)
+    {
+        return SUCCEED;
+    }
+    return FAILED;
+}
+/******************************************************************************
+ * @brief Queue a Msg to send to a container without waiting for its transmission
+ * @param container to send
+ * @param msg to send, it can be reused as soon as this function return (it is copied, or pinned if it is into msg_buffer)
+ * @param tx_cb function called by Transmit_Loop at the end of the transmission, can be NULL
+ * @param tx_id pointer to save the message identifier used by Robus_GetTxStatus, can be NULL
+ * @return FAILED if the transmission queue is full
+ * @warning A msg with more than MAX_DATA_MSG_SIZE bytes have to be allocated into msg_buffer (see MsgAlloc_ReserveMsg).
+ * @warning The containers of this node get the message right now, before its
+ *          transmission on the bus and whatever its result is. A localhost
+ *          failure is reported by the transmission status.
+ ******************************************************************************/
+error_return_t Robus_SendMsgAsync(ll_container_t *ll_container, msg_t *msg, TX_CB tx_cb, uint16_t *tx_id)
+{
+    return Robus_QueueMsg(ll_container, msg, tx_cb, tx_id, false);
+}
+/******************************************************************************
+ * @brief Queue a Msg to send, copying it only if the sender can reuse it before the end of the transmission
+ * @param container to send
+ * @param msg to send
+ * @param tx_cb function called by Transmit_Loop at the end of the transmission, can be NULL
+ * @param tx_id pointer to save the message identifier used by Robus_GetTxStatus, can be NULL
+ * @param keep_msg true if msg stay valid until the end of the transmission
+ * @return FAILED if the transmission queue is full
+ ******************************************************************************/
+static error_return_t Robus_QueueMsg(ll_container_t *ll_container, msg_t *msg, TX_CB tx_cb, uint16_t *tx_id, uint8_t keep_msg)
 {
     // Compute the full message size based on the header size info.
     uint16_t data_size = 0;
-    uint16_t crc_val = 0xFFFF;
+    uint16_t crc_val = CRC_INIT_VAL;
+    error_return_t result = SUCCEED;
+    uint16_t id;
+    msg_t *pinned_msg = NULL;
 
-    if (msg->header.size > MAX_DATA_MSG_SIZE)
+    if (Transmit_IsFull())
     {
-        data_size = MAX_DATA_MSG_SIZE;
+        // If this message have been reserved into the allocator release it
+        MsgAlloc_CancelMsg(msg);
+        return FAILED;
+    }
+    if (msg->header.size > MAX_FRAME_DATA_SIZE)
+    {
+        data_size = MAX_FRAME_DATA_SIZE;
     }
     else
     {
@@ -165,119 +272,104 @@ error_return_t Robus_SendMsg(ll_container_t *ll_container, msg_t *msg)
     // Add the CRC to the total size of the message
     full_size += 2;
 
-
     // compute the CRC
-    for (uint16_t i = 0; i < full_size - 2; i++)
-    {
-        LuosHAL_ComputeCRC(&msg->stream[i], (uint8_t *)&crc_val);
-    }
+    crc_val = Crc_Update(crc_val, msg->stream, full_size - 2);
     msg->stream[full_size - 2] = (uint8_t)(crc_val);
     msg->stream[full_size - 1] = (uint8_t)(crc_val >> 8);
 
-
-    //try to send msg computed
-    error_return_t result = SUCCEED;
-    uint8_t nbr_nak_retry = 0;
-    uint8_t RetryCollision = 0;
     uint8_t NodeIsConcerned = (Recep_NodeConcerned(&msg->header) && (msg->header.target != DEFAULTID));
-ack_restart:
-    nbr_nak_retry++;
-    RetryCollision = 0;
-    LuosHAL_SetIrqState(false);
-    ctx.ack = 0;
-    LuosHAL_SetIrqState(true);
-    // Send message
-    while (Transmit_Process((uint8_t *)msg->stream, full_size))
-    {
-        // There is a collision
-        LuosHAL_SetIrqState(false);
-        // switch reception in header mode
-        ctx.rx.callback = Recep_GetHeader;
-        LuosHAL_SetIrqState(true);
-        // wait timeout of collided packet
-        Transmit_WaitUnlockTx();
-        //max collision possible
-        RetryCollision++;
-        if(RetryCollision > NBR_NAK_RETRY)
-        {
-            result = FAILED;
-            break;
-        }
-        // timer proportional to ID
-        if (ll_container->id > 1)
-        {
-            Robus_DelayUs((uint32_t)((ll_container->id - 1)*RetryCollision));
-        }
-    }
-    if(*ll_container->ll_stat.max_collision_retry < RetryCollision)
+    // A message of msg_buffer (reserved or received) is pinned, its space stay valid until the end of the transmission without copy
+    if (MsgAlloc_PinMsg(msg) == SUCCEED)
     {
-        *ll_container->ll_stat.max_collision_retry = RetryCollision;
+        pinned_msg = msg;
     }
-    // Check if ACK needed
-    if ((msg->header.target_mode == IDACK) || (msg->header.target_mode == NODEIDACK))
+    // localhost management, done at enqueue because a reserved message can't stay uncommited during the transmission
+    if (Recep_NodeConcerned(&msg->header))
     {
-        // Check if it is a localhost message
-        if (NodeIsConcerned == true)
+        // set message into the allocator, if this message have been reserved into the allocator there is nothing to copy
+        if (MsgAlloc_CommitMsg(msg) == FAILED)
         {
-            Transmit_SendAck();
-            ctx.ack = 0;
-        }
-        else
-        {
-            // ACK needed, change the state of state machine for wait a ACK
-            LuosHAL_SetIrqState(false);
-            ctx.rx.callback = Recep_CatchAck;
-            LuosHAL_SetIrqState(true);
-            while (ctx.tx.lock != false)
-            {
-                if(ctx.ack != 0)
-                {
-                    break;
-                }
-            }
-            status_t status;
-            status.unmap = ctx.ack;
-            if ((status.rx_error) | (status.identifier != 0x0F))
+            if (MsgAlloc_SetMessage(msg) == FAILED)
             {
-                if ((ctx.ack) && (status.identifier != 0x0F))
-                {
-                    // This is probably a part of another message
-                    // Send it to header
-                    LuosHAL_SetIrqState(false);
-                    ctx.rx.callback = Recep_GetHeader;
-                    LuosHAL_SetIrqState(true);
-                    Recep_GetHeader(&ctx.ack);
-                }
-                if (nbr_nak_retry < NBR_NAK_RETRY)
-                {
-                    Robus_DelayUs((uint32_t)(10*nbr_nak_retry));
-                    goto ack_restart;
-                }
-                else
-                {
-                    // Set the dead container ID into the ll_container
-                    result = FAILED;
-                    ll_container->dead_container_spotted = (uint16_t)(msg->header.target);
-                }
+                // There is no space to save this message
+                result = FAILED;
             }
-            ctx.ack = 0;
-        }
-        if(*ll_container->ll_stat.max_nak_retry < nbr_nak_retry)
-        {
-            *ll_container->ll_stat.max_nak_retry = nbr_nak_retry;
         }
     }
-
-    // localhost management
-    if (Recep_NodeConcerned(&msg->header))
+    else
+    {
+        // If this message have been reserved into the allocator release it
+        MsgAlloc_CancelMsg(msg);
+    }
+    // Robus_Loop will send it
+    if ((pinned_msg != NULL) || (keep_msg == true))
+    {
+        id = Transmit_EnqueueRef(ll_container, msg->stream, full_size, NodeIsConcerned, result, tx_cb, pinned_msg);
+    }
+    else
     {
-        // Reset potential residue of collision detection
-        Recep_Reset();
-        MsgAlloc_InvalidMsg();
-        // set message into the allocator
-        MsgAlloc_SetMessage(msg);
+        // The sender can reuse msg as soon as we return, copy it
+        id = Transmit_Enqueue(ll_container, msg->stream, full_size, NodeIsConcerned, result, tx_cb);
     }
-    return result;
+    if (tx_id != NULL)
+    {
+        *tx_id = id;
+    }
+    return SUCCEED;
+}
+/******************************************************************************
+ * @brief Pack a Msg with the others sent to the same node during AGGREGATION_WINDOW_US
+ * @param container to send
+ * @param node_id node hosting the target container
+ * @param msg to send, it is copied and can be reused as soon as this function return
+ * @return FAILED if the transmission queue is full
+ ******************************************************************************/
+error_return_t Robus_AggregateMsg(ll_container_t *ll_container, uint16_t node_id, msg_t *msg)
+{
+    return Aggr_AddMsg(ll_container, node_id, msg);
+}
+/******************************************************************************
+ * @brief Send the pending aggregated messages without waiting for the end of the window
+ * @param None
+ * @return FAILED if the transmission queue is full
+ ******************************************************************************/
+error_return_t Robus_FlushAggregation(void)
+{
+    return Aggr_Flush();
+}
+/******************************************************************************
+ * @brief catch the next message received by a container with this cmd instead of creating a luos task
+ * @param ll_container container waiting for the message, NULL to stop catching
+ * @param cmd command of the waited message
+ * @param msg place to copy the caught message, the last one received is kept
+ * @return None
+ * @warning This is made for blocking waits running Robus_Loop, they can't pull luos tasks
+ *          without disturbing the Luos_Loop calling them.
+ ******************************************************************************/
+void Robus_CatchMsg(ll_container_t *ll_container, uint8_t cmd, msg_t *msg)
+{
+    catch_done = false;
+    catch_cmd = cmd;
+    catch_msg = msg;
+    catch_ll_container = ll_container;
+}
+/******************************************************************************
+ * @brief check if the message waited by Robus_CatchMsg has been received
+ * @param None
+ * @return true if a message has been caught since Robus_CatchMsg
+ ******************************************************************************/
+uint8_t Robus_MsgCaught(void)
+{
+    return catch_done;
+}
+/******************************************************************************
+ * @brief get the transmission status of a message sent with Robus_SendMsgAsync
+ * @param tx_id message identifier given by Robus_SendMsgAsync
+ * @return tx_status_t
+ ******************************************************************************/
+tx_status_t Robus_GetTxStatus(uint16_t tx_id)
+{
+    return Transmit_GetStatus(tx_id);
 }
 /******************************************************************************
  * @brief Start a topology detection procedure
@@ -297,6 +389,7 @@ redetect:
 
     // setup sending ll_container
     ll_container->id = 1;
+    Trgt_UpdateFilters();
 
     if (Robus_DetectNextNodes(ll_container) == FAILED)
     {
@@ -333,8 +426,9 @@ static error_return_t Robus_ResetNetworkDetection(ll_container_t *ll_container)
         MsgAlloc_Init(NULL);
 
         // wait for some 2ms to be sure all previous messages are received and treated
-        uint32_t start_tick = LuosHAL_GetSystick();
-        while (LuosHAL_GetSystick() - start_tick < 2)
+        deadline_t deadline;
+        Timing_SetDeadline(&deadline, 2000);
+        while (!Timing_IsExpired(&deadline))
             ;
         try++;
     } while ((MsgAlloc_IsEmpty() != SUCCEED) || (try > 5));
@@ -376,11 +470,12 @@ static error_return_t Robus_DetectNextNodes(ll_container_t *ll_container)
         }
         // when Robus loop will receive the reply it will store and manage the new node_id and send it to the next node.
         // We just have to wait the end of the treatment of the entire branch
-        uint32_t start_tick = LuosHAL_GetSystick();
+        deadline_t deadline;
+        Timing_SetDeadline(&deadline, 1000000);
         while (ctx.port.keepLine)
         {
             Robus_Loop();
-            if (LuosHAL_GetSystick() - start_tick > 1000)
+            if (Timing_IsExpired(&deadline))
             {
                 // topology detection is too long, we should abort it and restart
                 return FAILED;
@@ -455,15 +550,42 @@ static error_return_t Robus_MsgHandler(msg_t *input)
         break;
     case SET_BAUDRATE:
         memcpy(&baudrate, input->data, sizeof(uint32_t));
-        LuosHAL_ComInit(baudrate);
+        Baud_Set(baudrate);
         return SUCCEED;
         break;
+    case BAUDRATE_TEST:
+    case BAUDRATE_PATTERN:
+    case BAUDRATE_REPORT:
+    case BAUDRATE_COMMIT:
+        return Baud_MsgHandler(ll_container, input);
+        break;
     default:
         return FAILED;
         break;
     }
     return FAILED;
 }
+/******************************************************************************
+ * @brief catch the message waited by Robus_CatchMsg, no luos task is created for it
+ * @param input message to check
+ * @return SUCCEED if the message is caught
+ ******************************************************************************/
+static error_return_t Robus_CatchHandler(msg_t *input)
+{
+    if ((catch_ll_container == NULL) || (input->header.cmd != catch_cmd) || (Recep_GetConcernedLLContainer(&input->header) != catch_ll_container))
+    {
+        return FAILED;
+    }
+    // Copy it, the message space will be released without luos task
+    uint16_t size = input->header.size;
+    if (size > MAX_DATA_MSG_SIZE)
+    {
+        size = MAX_DATA_MSG_SIZE;
+    }
+    memcpy(catch_msg->stream, input->stream, sizeof(header_t) + size);
+    catch_done = true;
+    return SUCCEED;
+}
 /******************************************************************************
  * @brief get node structure
  * @param None
@@ -474,16 +596,40 @@ node_t *Robus_GetNode(void)
     return (node_t *)&ctx.node;
 }
 /******************************************************************************
- * @brief Delay
+ * @brief get reception statistics
  * @param None
- * @return Node pointer
+ * @return statistics pointer
+ ******************************************************************************/
+robus_stats_t *Robus_GetStats(void)
+{
+    return (robus_stats_t *)&ctx.stats;
+}
+/******************************************************************************
+ * @brief set the baudrate of this node
+ * @param baudrate
+ * @return None
+ ******************************************************************************/
+void Robus_SetBaudrate(uint32_t baudrate)
+{
+    Baud_Set(baudrate);
+}
+/******************************************************************************
+ * @brief find the highest baudrate handled by all nodes, must be called after a topology detection by the detecting node
+ * @param ll_container sending the negotiation messages
+ * @param baudrates candidates sorted from the preferred one
+ * @param baudrate_nbr number of candidates
+ * @return the baudrate used by the network at the end of the negotiation
+ ******************************************************************************/
+uint32_t Robus_NegotiateBaudrate(ll_container_t *ll_container, const uint32_t *baudrates, uint8_t baudrate_nbr)
+{
+    return Baud_Negotiate(ll_container, last_node, baudrates, baudrate_nbr);
+}
+/******************************************************************************
+ * @brief Delay
+ * @param delay in us
+ * @return None
  ******************************************************************************/
 void Robus_DelayUs(uint32_t delay)
 {
-    uint32_t timeout = (((MCUFREQ/2)/1000000)*delay)+1;
-    volatile uint32_t i = 0;
-    while(i < timeout)
-    {
-        i++;
-    }
+    Timing_DelayUs(delay);
 }
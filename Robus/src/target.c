@@ -1,17 +1,63 @@
 /******************************************************************************
  * @file target
- * @brief multicast protocole description
+ * @brief multicast protocole description and target filtering
  * @author Luos
  * @version 0.0.0
  ******************************************************************************/
 #include "target.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include "luos_hal.h"
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+#define ID_BITMAP_SIZE ((BROADCAST_VAL + 1) / 32)
+#define CONTAINER_MAP_MASK (CONTAINER_MAP_SIZE - 1)
+#define MULTICAST_MAP_MASK (MULTICAST_MAP_SIZE - 1)
+#define NO_CONTAINER 0xFF
+
+#if ((CONTAINER_MAP_SIZE & CONTAINER_MAP_MASK) != 0) || (CONTAINER_MAP_SIZE < 2 * MAX_CONTAINER_NUMBER)
+#error "CONTAINER_MAP_SIZE must be a power of 2 at least twice bigger than MAX_CONTAINER_NUMBER"
+#endif
+
+#if ((MULTICAST_MAP_SIZE & MULTICAST_MAP_MASK) != 0) || (MULTICAST_MAP_SIZE < 2 * MAX_CONTAINER_NUMBER * MAX_MULTICAST_ADDRESS)
+#error "MULTICAST_MAP_SIZE must be a power of 2 at least twice bigger than MAX_CONTAINER_NUMBER * MAX_MULTICAST_ADDRESS"
+#endif
+
+typedef struct
+{
+    uint16_t id;   /*!< Container ID. */
+    uint8_t index; /*!< Index of the container into ll_container_table, NO_CONTAINER if this entry is free. */
+} id_entry_t;
+
+typedef struct
+{
+    uint16_t type;         /*!< Container type. */
+    container_mask_t mask; /*!< Containers of this type, 0 if this entry is free. */
+} type_entry_t;
+
+typedef struct
+{
+    uint16_t group;        /*!< Multicast group. */
+    container_mask_t mask; /*!< Containers in this group, 0 if this entry is free. */
+} group_entry_t;
 
 /*******************************************************************************
  * Variables
  ******************************************************************************/
+/*
+ * Lookup structures allowing reception to filter messages without looking at all the containers:
+ * id_bitmap have one bit per ID of this node, multicast_bitmap have one bit per multicast group
+ * joined by a container of this node, id_map, type_map and group_map are open addressing hash
+ * tables (linear probing) of the containers by ID, by type and by multicast group.
+ * They are rebuilt by Trgt_UpdateFilters each time a container ID, type or multicast group change.
+ */
+static volatile uint32_t id_bitmap[ID_BITMAP_SIZE];
+static volatile uint32_t multicast_bitmap[ID_BITMAP_SIZE];
+static volatile id_entry_t id_map[CONTAINER_MAP_SIZE];
+static volatile type_entry_t type_map[CONTAINER_MAP_SIZE];
+static volatile group_entry_t group_map[MULTICAST_MAP_SIZE];
 
 /*******************************************************************************
  * Function
@@ -37,9 +83,280 @@ uint8_t Trgt_MulticastTargetBank(ll_container_t *ll_container, uint16_t val)
  * @brief add a target to the bank
  * @param container in multicast
  * @param target to add
- * @return Error
+ * @return error_return_t : FAILED if the bank is full
  ******************************************************************************/
-void Trgt_AddMulticastTarget(ll_container_t *ll_container, uint16_t target)
+error_return_t Trgt_AddMulticastTarget(ll_container_t *ll_container, uint16_t target)
 {
+    target &= BROADCAST_VAL;
+    if (Trgt_MulticastTargetBank(ll_container, target))
+    {
+        // Already in this group
+        return SUCCEED;
+    }
+    if (ll_container->max_multicast_target >= MAX_MULTICAST_ADDRESS)
+    {
+        return FAILED;
+    }
     ll_container->multicast_target_bank[ll_container->max_multicast_target++] = target;
+    Trgt_UpdateFilters();
+    return SUCCEED;
+}
+/******************************************************************************
+ * @brief remove a target from the bank
+ * @param container in multicast
+ * @param target to remove
+ * @return error_return_t : FAILED if the target is not in the bank
+ ******************************************************************************/
+error_return_t Trgt_RemoveMulticastTarget(ll_container_t *ll_container, uint16_t target)
+{
+    target &= BROADCAST_VAL;
+    for (uint16_t i = 0; i < ll_container->max_multicast_target; i++)
+    {
+        if (ll_container->multicast_target_bank[i] == target)
+        {
+            // Replace it by the last one
+            ll_container->max_multicast_target--;
+            ll_container->multicast_target_bank[i] = ll_container->multicast_target_bank[ll_container->max_multicast_target];
+            Trgt_UpdateFilters();
+            return SUCCEED;
+        }
+    }
+    return FAILED;
+}
+/******************************************************************************
+ * @brief check if a container of this node is in this multicast group
+ * @param target : the multicast group
+ * @return TRUE if a container is in this group
+ ******************************************************************************/
+uint8_t Trgt_MulticastConcerned(uint16_t target)
+{
+    target &= BROADCAST_VAL;
+    return (multicast_bitmap[target >> 5] >> (target & 0x1F)) & 1;
+}
+/******************************************************************************
+ * @brief find all the containers of a multicast group
+ * @param target : the multicast group
+ * @return the mask of containers indexes, 0 if there is no container in this group
+ ******************************************************************************/
+container_mask_t Trgt_GetMulticastMask(uint16_t target)
+{
+    uint16_t slot;
+    if (Trgt_MulticastConcerned(target) == FALSE)
+    {
+        return 0;
+    }
+    target &= BROADCAST_VAL;
+    slot = target & MULTICAST_MAP_MASK;
+    while (group_map[slot].mask != 0)
+    {
+        if (group_map[slot].group == target)
+        {
+            return group_map[slot].mask;
+        }
+        slot = (slot + 1) & MULTICAST_MAP_MASK;
+    }
+    return 0;
+}
+/******************************************************************************
+ * @brief clear target filters
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Trgt_Init(void)
+{
+    memset((void *)id_bitmap, 0, sizeof(id_bitmap));
+    memset((void *)multicast_bitmap, 0, sizeof(multicast_bitmap));
+    for (uint16_t i = 0; i < CONTAINER_MAP_SIZE; i++)
+    {
+        id_map[i].index = NO_CONTAINER;
+        type_map[i].mask = 0;
+    }
+    for (uint16_t i = 0; i < MULTICAST_MAP_SIZE; i++)
+    {
+        group_map[i].mask = 0;
+    }
+}
+/******************************************************************************
+ * @brief rebuild target filters from ll_container_table, call it each time a container ID, type or group change
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Trgt_UpdateFilters(void)
+{
+    uint16_t slot;
+    uint16_t id;
+    uint16_t type;
+    // Reception use filters, update them in one shot
+    LuosHAL_SetIrqState(false);
+    // Remove the previous IDs, types and groups
+    for (slot = 0; slot < CONTAINER_MAP_SIZE; slot++)
+    {
+        if (id_map[slot].index != NO_CONTAINER)
+        {
+            id_bitmap[id_map[slot].id >> 5] &= ~((uint32_t)1 << (id_map[slot].id & 0x1F));
+            id_map[slot].index = NO_CONTAINER;
+        }
+        type_map[slot].mask = 0;
+    }
+    for (slot = 0; slot < MULTICAST_MAP_SIZE; slot++)
+    {
+        group_map[slot].mask = 0;
+    }
+    memset((void *)multicast_bitmap, 0, sizeof(multicast_bitmap));
+    // Add the actual ones
+    for (uint8_t i = 0; i < ctx.ll_container_number; i++)
+    {
+        id = ctx.ll_container_table[i].id & BROADCAST_VAL;
+        id_bitmap[id >> 5] |= ((uint32_t)1 << (id & 0x1F));
+        slot = id & CONTAINER_MAP_MASK;
+        while ((id_map[slot].index != NO_CONTAINER) && (id_map[slot].id != id))
+        {
+            slot = (slot + 1) & CONTAINER_MAP_MASK;
+        }
+        if (id_map[slot].index == NO_CONTAINER)
+        {
+            // If multiple containers have the same ID, keep the first one
+            id_map[slot].id = id;
+            id_map[slot].index = i;
+        }
+
+        type = ctx.ll_container_table[i].type;
+        slot = type & CONTAINER_MAP_MASK;
+        while ((type_map[slot].mask != 0) && (type_map[slot].type != type))
+        {
+            slot = (slot + 1) & CONTAINER_MAP_MASK;
+        }
+        type_map[slot].type = type;
+        type_map[slot].mask |= ((container_mask_t)1 << i);
+
+        for (uint16_t j = 0; j < ctx.ll_container_table[i].max_multicast_target; j++)
+        {
+            id = ctx.ll_container_table[i].multicast_target_bank[j];
+            multicast_bitmap[id >> 5] |= ((uint32_t)1 << (id & 0x1F));
+            slot = id & MULTICAST_MAP_MASK;
+            while ((group_map[slot].mask != 0) && (group_map[slot].group != id))
+            {
+                slot = (slot + 1) & MULTICAST_MAP_MASK;
+            }
+            group_map[slot].group = id;
+            group_map[slot].mask |= ((container_mask_t)1 << i);
+        }
+    }
+    LuosHAL_SetIrqState(true);
+}
+/******************************************************************************
+ * @brief check if a container of this node have this ID
+ * @param id : the ID to check
+ * @return TRUE if a container have this ID
+ ******************************************************************************/
+uint8_t Trgt_IdConcerned(uint16_t id)
+{
+    id &= BROADCAST_VAL;
+    return (id_bitmap[id >> 5] >> (id & 0x1F)) & 1;
+}
+/******************************************************************************
+ * @brief find the container with this ID
+ * @param id : the ID to find
+ * @return ll_container pointer, NULL if there is no container with this ID
+ ******************************************************************************/
+ll_container_t *Trgt_GetContainerFromId(uint16_t id)
+{
+    uint16_t slot;
+    if (Trgt_IdConcerned(id) == FALSE)
+    {
+        return NULL;
+    }
+    slot = id & CONTAINER_MAP_MASK;
+    while (id_map[slot].index != NO_CONTAINER)
+    {
+        if (id_map[slot].id == id)
+        {
+            return (ll_container_t *)&ctx.ll_container_table[id_map[slot].index];
+        }
+        slot = (slot + 1) & CONTAINER_MAP_MASK;
+    }
+    return NULL;
+}
+/******************************************************************************
+ * @brief find all the containers of this type
+ * @param type : the type to find
+ * @return the mask of containers indexes, 0 if there is no container of this type
+ ******************************************************************************/
+container_mask_t Trgt_GetTypeMask(uint16_t type)
+{
+    uint16_t slot = type & CONTAINER_MAP_MASK;
+    while (type_map[slot].mask != 0)
+    {
+        if (type_map[slot].type == type)
+        {
+            return type_map[slot].mask;
+        }
+        slot = (slot + 1) & CONTAINER_MAP_MASK;
+    }
+    return 0;
+}
+/******************************************************************************
+ * @brief find the first container of this type
+ * @param type : the type to find
+ * @return ll_container pointer, NULL if there is no container of this type
+ ******************************************************************************/
+ll_container_t *Trgt_GetContainerFromType(uint16_t type)
+{
+    container_mask_t mask = Trgt_GetTypeMask(type);
+    uint8_t i = 0;
+    if (mask == 0)
+    {
+        return NULL;
+    }
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        i++;
+    }
+    return (ll_container_t *)&ctx.ll_container_table[i];
+}
+/******************************************************************************
+ * @brief replace the cmd filter of a container
+ * @param ll_container
+ * @param cmd_filter : one bit per accepted cmd
+ * @return None
+ ******************************************************************************/
+void Trgt_SetCmdFilter(ll_container_t *ll_container, const uint32_t *cmd_filter)
+{
+    // Reception use filters, update it in one shot
+    LuosHAL_SetIrqState(false);
+    memcpy((void *)ll_container->cmd_filter, cmd_filter, sizeof(ll_container->cmd_filter));
+    LuosHAL_SetIrqState(true);
+}
+/******************************************************************************
+ * @brief check if a container accept a cmd
+ * @param ll_container
+ * @param cmd : the cmd to check
+ * @return TRUE if this cmd is accepted
+ ******************************************************************************/
+uint8_t Trgt_CmdAccepted(ll_container_t *ll_container, uint8_t cmd)
+{
+    if (IS_ROBUS_CMD(cmd))
+    {
+        // Robus protocol cmds are never filtered
+        return TRUE;
+    }
+    return (ll_container->cmd_filter[cmd >> 5] >> (cmd & 0x1F)) & 1;
+}
+/******************************************************************************
+ * @brief remove the containers not accepting a cmd from a mask
+ * @param container_mask : the mask of containers indexes
+ * @param cmd : the cmd to check
+ * @return the mask of containers indexes accepting this cmd
+ ******************************************************************************/
+container_mask_t Trgt_CmdFilterMask(container_mask_t container_mask, uint8_t cmd)
+{
+    for (uint16_t i = 0; i < ctx.ll_container_number; i++)
+    {
+        if ((container_mask & ((container_mask_t)1 << i)) && (Trgt_CmdAccepted((ll_container_t *)&ctx.ll_container_table[i], cmd) == FALSE))
+        {
+            container_mask &= ~((container_mask_t)1 << i);
+        }
+    }
+    return container_mask;
 }
@@ -0,0 +1,159 @@
+/******************************************************************************
+ * @file timing
+ * @brief Robus microsecond clock, delays and deadlines
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include "timing.h"
+
+#include "luos_hal.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TIMING_CALIBRATION_STEP 100 // delay loops between two systick reads during calibration
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t delay_loop_per_ms = (MCUFREQ / 2) / 1000; /*!< Number of delay loops during 1ms, default assume 2 cycles per loop. */
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+#if (US_TICK_HAL == FALSE)
+static void Timing_Spin(uint32_t loop_nbr);
+static void Timing_Calibrate(void);
+#endif
+
+/******************************************************************************
+ * @brief init the timing service, must be called after the HAL init
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Timing_Init(void)
+{
+#if (US_TICK_HAL == FALSE)
+    Timing_Calibrate();
+#endif
+}
+/******************************************************************************
+ * @brief get the monotonic microsecond clock
+ * @param None
+ * @return date in us, wrapping on 32 bits
+ ******************************************************************************/
+uint32_t Timing_GetUs(void)
+{
+#if (US_TICK_HAL == TRUE)
+    return LuosHAL_GetUsTick();
+#else
+    // Without a HAL microsecond counter the resolution is 1ms
+    return LuosHAL_GetSystick() * 1000;
+#endif
+}
+/******************************************************************************
+ * @brief blocking delay
+ * @param delay in us
+ * @return None
+ ******************************************************************************/
+void Timing_DelayUs(uint32_t delay)
+{
+#if (US_TICK_HAL == TRUE)
+    uint32_t start = LuosHAL_GetUsTick();
+    while ((uint32_t)(LuosHAL_GetUsTick() - start) < delay)
+        ;
+#else
+    // split the computation to avoid overflows
+    Timing_Spin((delay_loop_per_ms * (delay % 1000)) / 1000 + delay_loop_per_ms * (delay / 1000) + 1);
+#endif
+}
+/******************************************************************************
+ * @brief set the delay loop calibration, allowing to use a value measured by the application
+ * @param loop_per_ms : number of delay loops during 1ms
+ * @return None
+ ******************************************************************************/
+void Timing_SetCalibration(uint32_t loop_per_ms)
+{
+    if (loop_per_ms > 0)
+    {
+        delay_loop_per_ms = loop_per_ms;
+    }
+}
+/******************************************************************************
+ * @brief get the delay loop calibration
+ * @param None
+ * @return number of delay loops during 1ms
+ ******************************************************************************/
+uint32_t Timing_GetCalibration(void)
+{
+    return delay_loop_per_ms;
+}
+/******************************************************************************
+ * @brief start a deadline
+ * @param deadline to start
+ * @param delay before expiration in us
+ * @return None
+ ******************************************************************************/
+void Timing_SetDeadline(deadline_t *deadline, uint32_t delay)
+{
+    deadline->start = Timing_GetUs();
+    deadline->duration = delay;
+}
+/******************************************************************************
+ * @brief check a deadline without waiting
+ * @param deadline to check
+ * @return true if the deadline is expired
+ ******************************************************************************/
+uint8_t Timing_IsExpired(deadline_t *deadline)
+{
+    return ((uint32_t)(Timing_GetUs() - deadline->start) >= deadline->duration);
+}
+#if (US_TICK_HAL == FALSE)
+/******************************************************************************
+ * @brief wait a number of delay loops
+ * @param loop_nbr : number of loops
+ * @return None
+ ******************************************************************************/
+static void Timing_Spin(uint32_t loop_nbr)
+{
+    volatile uint32_t i = 0;
+    while (i < loop_nbr)
+    {
+        i++;
+    }
+}
+/******************************************************************************
+ * @brief measure the number of delay loops during 1ms using the systick
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void Timing_Calibrate(void)
+{
+    // If the systick doesn't run keep the default value
+    uint32_t max_step = (4 * TIMING_CALIBRATION_MS * delay_loop_per_ms) / TIMING_CALIBRATION_STEP + 1;
+    uint32_t step = 0;
+    uint32_t start_tick = LuosHAL_GetSystick();
+    // synchronize on a systick edge
+    while ((LuosHAL_GetSystick() == start_tick) && (step < max_step))
+    {
+        Timing_Spin(TIMING_CALIBRATION_STEP);
+        step++;
+    }
+    if (step >= max_step)
+    {
+        return;
+    }
+    step = 0;
+    start_tick = LuosHAL_GetSystick();
+    while ((LuosHAL_GetSystick() - start_tick < TIMING_CALIBRATION_MS) && (step < max_step))
+    {
+        Timing_Spin(TIMING_CALIBRATION_STEP);
+        step++;
+    }
+    if (step >= max_step)
+    {
+        return;
+    }
+    Timing_SetCalibration((step * TIMING_CALIBRATION_STEP) / TIMING_CALIBRATION_MS);
+}
+#endif
@@ -11,19 +11,62 @@
 #include <stdbool.h>
 #include "context.h"
 #include "reception.h"
+#include "msg_alloc.h"
+#include "luos_utils.h"
+#include "timing.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+#define TX_MSG_MASK (MAX_TX_MSG_NB - 1)
+
+#if ((MAX_TX_MSG_NB & TX_MSG_MASK) != 0)
+#error "MAX_TX_MSG_NB must be a power of 2"
+#endif
+
+typedef enum
+{
+    TX_SEND_STEP,    /*!< Wait for a free bus and send the message. */
+    TX_WAIT_ACK_STEP /*!< Wait for the ack of the sent message. */
+} tx_step_t;
+
+typedef struct
+{
+    uint8_t stream[sizeof(header_t) + MAX_FRAME_DATA_SIZE + 2]; /*!< Copy of the message to send with its CRC. */
+    uint8_t *data;                                              /*!< Stream to send, the copy or the message of the sender. */
+    msg_t *pinned_msg;                                          /*!< Message of msg_buffer sent without copy, unpinned at the end of the transmission. */
+    uint16_t size;                                              /*!< Size of the stream to send. */
+    uint16_t tx_id;                                             /*!< Identifier of this message, used to get its status. */
+    ll_container_t *ll_container;                               /*!< Container sending this message. */
+    TX_CB tx_cb;                                                /*!< Function called at the end of the transmission, can be NULL. */
+    uint8_t localhost;                                          /*!< True if this node is concerned by the message. */
+    uint8_t collision_retry;                                    /*!< Number of collisions of the current try. */
+    uint8_t nak_retry;                                          /*!< Number of tries. */
+    deadline_t retry_deadline;                                  /*!< Date of the next try after a collision or a NAK. */
+    error_return_t result;                                      /*!< Transmission result, FAILED if the localhost management failed. */
+    volatile tx_status_t status;                                /*!< Transmission status. */
+} tx_task_t;
 
 /*******************************************************************************
  * Variables
  ******************************************************************************/
+static tx_task_t tx_tasks[MAX_TX_MSG_NB]; /*!< Ring queue of the messages waiting for transmission. */
+static uint16_t tx_tasks_in;              /*!< Number of messages added into tx_tasks since init, also the next tx_id. */
+static uint16_t tx_tasks_out;             /*!< Number of messages removed from tx_tasks since init. */
+static tx_step_t tx_step;                 /*!< Transmission step of the oldest message of tx_tasks. */
+static backoff_policy_t backoff_policy = COLLISION_BACKOFF; /*!< Waiting time computation after a collision. */
+static uint32_t backoff_seed;                               /*!< Pseudo random generator state used by backoff jitter, 0 if not seeded. */
 
 /*******************************************************************************
  * Function
  ******************************************************************************/
 static uint8_t Transmit_GetLockStatus(void);
+static void Transmit_SendTask(tx_task_t *task);
+static void Transmit_CheckAck(tx_task_t *task);
+static void Transmit_EndTask(tx_task_t *task, error_return_t result);
+static tx_task_t *Transmit_AddTask(ll_container_t *ll_container, uint16_t size, uint8_t localhost, error_return_t result, TX_CB tx_cb);
+static uint32_t Transmit_GetBackoff(tx_task_t *task);
+static uint32_t Transmit_Random(void);
 
 /******************************************************************************
  * @brief detect network topologie
@@ -42,15 +85,13 @@ void Transmit_SendAck(void)
 }
 /******************************************************************************
  * @brief transmission process
+ * @warning The bus have to be free (see Transmit_WaitUnlockTx), Transmit_Loop check it before.
  * @param pointer data to send
  * @param size of data to send
  * @return Error
  ******************************************************************************/
 error_return_t Transmit_Process(uint8_t *data, uint16_t size)
 {
-    // wait tx unlock
-    Transmit_WaitUnlockTx();
-
     // Remove IT detection Rx on Pin
     LuosHAL_SetTxLockDetecState(false);
 
@@ -99,3 +140,343 @@ static uint8_t Transmit_GetLockStatus(void)
     }
     return ctx.tx.lock;
 }
+/******************************************************************************
+ * @brief init the transmission queue
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Transmit_Init(void)
+{
+    memset((void *)tx_tasks, 0, sizeof(tx_tasks));
+    tx_tasks_in = 0;
+    tx_tasks_out = 0;
+    tx_step = TX_SEND_STEP;
+}
+/******************************************************************************
+ * @brief check if there is space into the transmission queue
+ * @param None
+ * @return true if there is no more space
+ ******************************************************************************/
+uint8_t Transmit_IsFull(void)
+{
+    return ((uint16_t)(tx_tasks_in - tx_tasks_out) >= MAX_TX_MSG_NB);
+}
+/******************************************************************************
+ * @brief add a copy of a message into the transmission queue
+ * @param ll_container sending the message
+ * @param data pointer to the message with its CRC
+ * @param size of data
+ * @param localhost true if this node is concerned by the message
+ * @param result of the localhost management
+ * @param tx_cb function called at the end of the transmission, can be NULL
+ * @return tx_id of the message
+ ******************************************************************************/
+uint16_t Transmit_Enqueue(ll_container_t *ll_container, uint8_t *data, uint16_t size, uint8_t localhost, error_return_t result, TX_CB tx_cb)
+{
+    tx_task_t *task = Transmit_AddTask(ll_container, size, localhost, result, tx_cb);
+    memcpy(task->stream, data, size);
+    task->data = task->stream;
+    task->pinned_msg = NULL;
+    tx_tasks_in++;
+    return task->tx_id;
+}
+/******************************************************************************
+ * @brief add a message into the transmission queue without copying it
+ * @param ll_container sending the message
+ * @param data pointer to the message with its CRC, it have to stay valid until the end of the transmission
+ * @param size of data
+ * @param localhost true if this node is concerned by the message
+ * @param result of the localhost management
+ * @param tx_cb function called at the end of the transmission, can be NULL
+ * @param pinned_msg message of msg_buffer pinned by the sender and unpinned at the end of the transmission, can be NULL
+ * @return tx_id of the message
+ ******************************************************************************/
+uint16_t Transmit_EnqueueRef(ll_container_t *ll_container, uint8_t *data, uint16_t size, uint8_t localhost, error_return_t result, TX_CB tx_cb, msg_t *pinned_msg)
+{
+    tx_task_t *task = Transmit_AddTask(ll_container, size, localhost, result, tx_cb);
+    task->data = data;
+    task->pinned_msg = pinned_msg;
+    tx_tasks_in++;
+    return task->tx_id;
+}
+/******************************************************************************
+ * @brief prepare the next slot of the transmission queue, Transmit_Enqueue publish it
+ * @param ll_container sending the message
+ * @param size of the message with its CRC
+ * @param localhost true if this node is concerned by the message
+ * @param result of the localhost management
+ * @param tx_cb function called at the end of the transmission, can be NULL
+ * @return task to fill with the message
+ ******************************************************************************/
+static tx_task_t *Transmit_AddTask(ll_container_t *ll_container, uint16_t size, uint8_t localhost, error_return_t result, TX_CB tx_cb)
+{
+    LUOS_ASSERT((Transmit_IsFull() == false) && (size <= sizeof(tx_tasks[0].stream)));
+    tx_task_t *task = &tx_tasks[tx_tasks_in & TX_MSG_MASK];
+    task->size = size;
+    task->tx_id = tx_tasks_in;
+    task->ll_container = ll_container;
+    task->tx_cb = tx_cb;
+    task->localhost = localhost;
+    task->collision_retry = 0;
+    task->nak_retry = 0;
+    Timing_SetDeadline(&task->retry_deadline, 0);
+    task->result = result;
+    task->status = TX_PENDING;
+    return task;
+}
+/******************************************************************************
+ * @brief get the transmission status of a message
+ * @param tx_id of the message
+ * @return tx_status_t
+ ******************************************************************************/
+tx_status_t Transmit_GetStatus(uint16_t tx_id)
+{
+    tx_task_t *task = &tx_tasks[tx_id & TX_MSG_MASK];
+    if ((task->tx_id != tx_id) || ((uint16_t)(tx_tasks_in - tx_id) > MAX_TX_MSG_NB) || ((uint16_t)(tx_tasks_in - tx_id) == 0))
+    {
+        // This message have been replaced by a newer one or doesn't exist yet
+        return TX_UNKNOWN;
+    }
+    return task->status;
+}
+/******************************************************************************
+ * @brief send the queued messages without waiting for a free bus, a retry date or an ack
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Transmit_Loop(void)
+{
+    tx_task_t *task;
+    while ((uint16_t)(tx_tasks_in - tx_tasks_out) > 0)
+    {
+        task = &tx_tasks[tx_tasks_out & TX_MSG_MASK];
+        if (tx_step == TX_SEND_STEP)
+        {
+            if (Timing_IsExpired(&task->retry_deadline) == false)
+            {
+                // Waiting before the next try, try again later
+                return;
+            }
+            if (Transmit_GetLockStatus())
+            {
+                // The bus is busy, try again later
+                return;
+            }
+            Transmit_SendTask(task);
+        }
+        else
+        {
+            if ((ctx.tx.lock != false) && (ctx.ack == 0))
+            {
+                // Ack not received yet, try again later
+                return;
+            }
+            Transmit_CheckAck(task);
+        }
+    }
+}
+/******************************************************************************
+ * @brief try to send the oldest message of the queue
+ * @param task to send
+ * @return None
+ ******************************************************************************/
+static void Transmit_SendTask(tx_task_t *task)
+{
+    header_t *header = (header_t *)task->data;
+    if (task->collision_retry == 0)
+    {
+        // This is a new try
+        task->nak_retry++;
+        LuosHAL_SetIrqState(false);
+        ctx.ack = 0;
+        LuosHAL_SetIrqState(true);
+    }
+    if (Transmit_Process(task->data, task->size) == FAILED)
+    {
+        // There is a collision
+        LuosHAL_SetIrqState(false);
+        // switch reception in header mode
+        ctx.rx.callback = Recep_GetHeader;
+        LuosHAL_SetIrqState(true);
+        //max collision possible
+        task->collision_retry++;
+        if (*task->ll_container->ll_stat.max_collision_retry < task->collision_retry)
+        {
+            *task->ll_container->ll_stat.max_collision_retry = task->collision_retry;
+        }
+        if (task->collision_retry > NBR_NAK_RETRY)
+        {
+            Transmit_EndTask(task, FAILED);
+            return;
+        }
+        // wait before the next try
+        uint32_t backoff = Transmit_GetBackoff(task);
+        Timing_SetDeadline(&task->retry_deadline, backoff);
+        if ((uint32_t)(ctx.stats.backoff_time + backoff) >= ctx.stats.backoff_time)
+        {
+            ctx.stats.backoff_time += backoff;
+        }
+        // The next try will also wait for the collided message to be finished
+        return;
+    }
+    task->collision_retry = 0;
+    // Check if ACK needed
+    if ((header->target_mode == IDACK) || (header->target_mode == NODEIDACK))
+    {
+        // Check if it is a localhost message
+        if (task->localhost == true)
+        {
+            Transmit_SendAck();
+            ctx.ack = 0;
+        }
+        else
+        {
+            // ACK needed, change the state of state machine for wait a ACK
+            LuosHAL_SetIrqState(false);
+            ctx.rx.callback = Recep_CatchAck;
+            LuosHAL_SetIrqState(true);
+            tx_step = TX_WAIT_ACK_STEP;
+            return;
+        }
+    }
+    Transmit_EndTask(task, SUCCEED);
+}
+/******************************************************************************
+ * @brief check the ack of the oldest message of the queue
+ * @param task waiting for an ack
+ * @return None
+ ******************************************************************************/
+static void Transmit_CheckAck(tx_task_t *task)
+{
+    status_t status;
+    status.unmap = ctx.ack;
+    tx_step = TX_SEND_STEP;
+    if ((status.rx_error) | (status.identifier != 0x0F))
+    {
+        if ((ctx.ack) && (status.identifier != 0x0F))
+        {
+            // This is probably a part of another message
+            // Send it to header
+            LuosHAL_SetIrqState(false);
+            ctx.rx.callback = Recep_GetHeader;
+            LuosHAL_SetIrqState(true);
+            Recep_GetHeader(&ctx.ack);
+        }
+        ctx.ack = 0;
+        if (task->nak_retry < NBR_NAK_RETRY)
+        {
+            // Try again after a delay
+            Timing_SetDeadline(&task->retry_deadline, (uint32_t)(10 * task->nak_retry));
+            return;
+        }
+        // Set the dead container ID into the ll_container
+        task->ll_container->dead_container_spotted = (uint16_t)(((header_t *)task->data)->target);
+        Transmit_EndTask(task, FAILED);
+        return;
+    }
+    ctx.ack = 0;
+    Transmit_EndTask(task, SUCCEED);
+}
+/******************************************************************************
+ * @brief remove the oldest message of the queue and notify its container
+ * @param task finished
+ * @param result of the transmission
+ * @return None
+ ******************************************************************************/
+static void Transmit_EndTask(tx_task_t *task, error_return_t result)
+{
+    header_t *header = (header_t *)task->data;
+    if (((header->target_mode == IDACK) || (header->target_mode == NODEIDACK)) && (*task->ll_container->ll_stat.max_nak_retry < task->nak_retry))
+    {
+        *task->ll_container->ll_stat.max_nak_retry = task->nak_retry;
+    }
+    if (task->localhost == true)
+    {
+        // Reset potential residue of collision detection
+        LuosHAL_SetIrqState(false);
+        Recep_Reset();
+        MsgAlloc_InvalidMsg();
+        LuosHAL_SetIrqState(true);
+    }
+    if (result == FAILED)
+    {
+        task->result = FAILED;
+    }
+    if (task->pinned_msg != NULL)
+    {
+        // The message is not needed anymore, release its space
+        MsgAlloc_UnpinMsg(task->pinned_msg);
+    }
+    task->status = (task->result == SUCCEED) ? TX_SUCCEED : TX_FAILED;
+    tx_step = TX_SEND_STEP;
+    // Free the slot before the callback allowing it to send other messages
+    tx_tasks_out++;
+    if (task->tx_cb != NULL)
+    {
+        task->tx_cb(task->ll_container, task->tx_id, task->result);
+    }
+}
+/******************************************************************************
+ * @brief select the waiting time computation after a collision
+ * @param policy : backoff policy
+ * @return None
+ ******************************************************************************/
+void Transmit_SetBackoffPolicy(backoff_policy_t policy)
+{
+    backoff_policy = policy;
+}
+/******************************************************************************
+ * @brief compute the waiting time before retrying a collided message
+ * @param task collided
+ * @return time to wait in us
+ ******************************************************************************/
+static uint32_t Transmit_GetBackoff(tx_task_t *task)
+{
+    uint8_t exponent = task->collision_retry;
+    switch (backoff_policy)
+    {
+    case ID_BACKOFF:
+        // timer proportional to ID
+        if (task->ll_container->id > 1)
+        {
+            return (uint32_t)((task->ll_container->id - 1) * task->collision_retry);
+        }
+        return 0;
+    case PRIORITY_BACKOFF:
+        if ((task->ll_container->priority == HIGH_PRIORITY) && (exponent > 1))
+        {
+            // High priority containers retry in a smaller window
+            exponent--;
+        }
+        // fall through
+    case EXPONENTIAL_BACKOFF:
+    default:
+        if (exponent > BACKOFF_MAX_EXPONENT)
+        {
+            exponent = BACKOFF_MAX_EXPONENT;
+        }
+        // random time into a window doubling at each collision
+        return Transmit_Random() % (((uint32_t)1 << exponent) * BACKOFF_SLOT_US);
+    }
+}
+/******************************************************************************
+ * @brief xorshift pseudo random generator used by backoff jitter
+ * @param None
+ * @return random value
+ ******************************************************************************/
+static uint32_t Transmit_Random(void)
+{
+    if (backoff_seed == 0)
+    {
+        // Seed it on the first collision, nodes colliding together have different IDs
+        backoff_seed = (Timing_GetUs() << 4) ^ ctx.node.node_id ^ ((uint32_t)ctx.stats.rx_frame_nbr << 20);
+        if (backoff_seed == 0)
+        {
+            backoff_seed = 0x2545F491;
+        }
+    }
+    backoff_seed ^= backoff_seed << 13;
+    backoff_seed ^= backoff_seed >> 17;
+    backoff_seed ^= backoff_seed << 5;
+    return backoff_seed;
+}
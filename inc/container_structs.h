@@ -57,8 +57,9 @@ typedef struct __attribute__((__packed__)) container_stats_t
             uint8_t msg_fail_ratio;
             uint8_t max_collision_retry;
             uint8_t max_nak_retry;
+            uint8_t msg_drop_nbr; /*!< Received messages dropped before being consumed by this container. */
         };
-        uint8_t unmap[3]; /*!< streamable form. */
+        uint8_t unmap[4]; /*!< streamable form. */
     };
 } container_stats_t;
 
@@ -34,6 +34,41 @@ typedef struct __attribute__((__packed__))
         uint8_t unmap[sizeof(luos_stats_t) + sizeof(container_stats_t)]; /*!< streamable form. */
     };
 } general_stats_t;
+
+/******************************************************************************
+ * @struct bulk_start_t
+ * @brief announce a bulk transfer, the data chunks are sent after it
+ ******************************************************************************/
+typedef struct __attribute__((__packed__))
+{
+    union
+    {
+        struct __attribute__((__packed__))
+        {
+            uint16_t size; /*!< Total size of the data. */
+            uint8_t cmd;   /*!< cmd of the data chunks. */
+        };
+        uint8_t unmap[3]; /*!< streamable form. */
+    };
+} bulk_start_t;
+
+/******************************************************************************
+ * @struct bulk_ack_t
+ * @brief cumulative and selective acknowledgment of a bulk transfer
+ ******************************************************************************/
+typedef struct __attribute__((__packed__))
+{
+    union
+    {
+        struct __attribute__((__packed__))
+        {
+            uint16_t size;     /*!< Total size of the data. */
+            uint16_t next;     /*!< First missing chunk, all the previous ones are received. */
+            uint32_t received; /*!< One bit per chunk received from next (bit 0 is next). */
+        };
+        uint8_t unmap[8]; /*!< streamable form. */
+    };
+} bulk_ack_t;
 /*******************************************************************************
  * Variables
  ******************************************************************************/
@@ -46,15 +81,34 @@ void Luos_Loop(void);
 void Luos_ContainersClear(void);
 container_t *Luos_CreateContainer(CONT_CB cont_cb, uint8_t type, const char *alias, revision_t revision);
 error_return_t Luos_SendMsg(container_t *container, msg_t *msg);
+error_return_t Luos_SendMsgAsync(container_t *container, msg_t *msg, TX_CB tx_cb, uint16_t *tx_id);
+tx_status_t Luos_GetTxStatus(uint16_t tx_id);
+error_return_t Luos_SendMsgAggregated(container_t *container, msg_t *msg);
+error_return_t Luos_FlushAggregation(void);
+error_return_t Luos_ReserveMsg(uint16_t size, msg_t **reserved_msg);
+void Luos_CancelMsg(msg_t *msg);
+error_return_t Luos_PinMsg(msg_t *msg);
+error_return_t Luos_UnpinMsg(msg_t *msg);
 error_return_t Luos_ReadMsg(container_t *container, msg_t **returned_msg);
+uint16_t Luos_ReadMsgBatch(container_t *container, msg_t **returned_msgs, uint16_t max_nbr);
+error_return_t Luos_ReleaseMsgBatch(container_t *container);
 error_return_t Luos_ReadFromContainer(container_t *container, int16_t id, msg_t **returned_msg);
 error_return_t Luos_SendData(container_t *container, msg_t *msg, void *bin_data, uint16_t size);
 error_return_t Luos_SendStreaming(container_t *container, msg_t *msg, streaming_channel_t *stream);
 error_return_t Luos_ReceiveStreaming(container_t *container, msg_t *msg, streaming_channel_t *stream);
 void Luos_SetBaudrate(uint32_t baudrate);
 void Luos_SendBaudrate(container_t *container, uint32_t baudrate);
+uint32_t Luos_NegotiateBaudrate(container_t *container, const uint32_t *baudrates, uint8_t baudrate_nbr);
 error_return_t Luos_SetExternId(container_t *container, target_mode_t target_mode, uint16_t target, uint16_t newid);
 uint16_t Luos_NbrAvailableMsg(void);
+void Luos_SetCoalescing(container_t *container, uint8_t enable);
+void Luos_SetQuota(container_t *container, uint8_t min_task, uint8_t max_task, uint16_t max_byte);
+void Luos_SetPriority(container_t *container, msg_priority_t priority);
+void Luos_SetCmdFilter(container_t *container, const uint8_t *cmd_list, uint16_t cmd_nbr);
+error_return_t Luos_JoinMulticastGroup(container_t *container, uint16_t group);
+error_return_t Luos_LeaveMulticastGroup(container_t *container, uint16_t group);
+void Luos_SetOverflowPolicy(overflow_policy_t policy);
+void Luos_SetBackoffPolicy(backoff_policy_t policy);
 error_return_t Luos_ReceiveData(container_t *container, msg_t *msg, void *bin_data);
 uint32_t Luos_GetSystick(void);
 
@@ -105,6 +105,11 @@ typedef enum
     HANDY_SET_POSITION, // handy_t
     PARAMETERS,         // depend on the container, can be : servo_parameters_t, imu_report_t, motor_mode_t
 
+    // Luos managed commands added after the existing ones to keep their value
+    ROBUS_STATISTICS, // container sends its node reception and bus health statistics
+    BULK_START,       // announce a windowed transfer of Luos_SendData chunks (bulk_start_t)
+    BULK_ACK,         // acknowledge the received chunks of a bulk transfer (bulk_ack_t)
+
     // compatibility area
     LUOS_PROTOCOL_NB,
 } luos_cmd_t;
@@ -64,6 +64,7 @@ uint16_t RoutingTB_IDFromType(luos_type_t type);
 uint16_t RoutingTB_IDFromContainer(container_t *container);
 char *RoutingTB_AliasFromId(uint16_t id);
 luos_type_t RoutingTB_TypeFromID(uint16_t id);
+uint16_t RoutingTB_NodeIDFromID(uint16_t id);
 luos_type_t RoutingTB_TypeFromAlias(char *alias);
 char *RoutingTB_StringFromType(luos_type_t type);
 uint8_t RoutingTB_ContainerIsSensor(luos_type_t type);
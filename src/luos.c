@@ -9,11 +9,29 @@
 #include <stdbool.h>
 #include "msg_alloc.h"
 #include "robus.h"
+#include "target.h"
+#include "transmission.h"
 #include "luos_hal.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+#define BULK_CHUNK_NB(size) (((size) + MAX_FRAME_DATA_SIZE - 1) / MAX_FRAME_DATA_SIZE)
+#define BULK_DONE_KEEP_MS   (2 * (NBR_BULK_RETRY + 1) * BULK_ACK_TIMEOUT_MS) // time a sender can retry after a lost final acknowledgment, windows transmission included
+
+/*
+ * Reception state of a bulk transfer (one per container)
+ */
+typedef struct
+{
+    uint16_t source;   /*!< Container sending the data. */
+    uint8_t cmd;       /*!< cmd of the data chunks. */
+    uint16_t size;     /*!< Total size of the data, 0 if this session is free. */
+    uint16_t next;     /*!< First missing chunk. */
+    uint32_t received; /*!< One bit per chunk received from next (bit 0 is next). */
+    uint8_t done;      /*!< True when all the chunks are received, the chunks sent again are only acknowledged. */
+    uint32_t date;     /*!< Systick of the end of the transfer. */
+} bulk_session_t;
 
 /*******************************************************************************
  * Variables
@@ -25,6 +43,7 @@ volatile routing_table_t *routing_table_pt;
 
 luos_stats_t luos_stats;
 general_stats_t general_stats;
+static bulk_session_t bulk_rx[MAX_CONTAINER_NUMBER];
 /*******************************************************************************
  * Function
  ******************************************************************************/
@@ -37,6 +56,15 @@ static error_return_t Luos_SaveAlias(container_t *container, uint8_t *alias);
 static void Luos_WriteAlias(uint16_t local_id, uint8_t *alias);
 static error_return_t Luos_ReadAlias(uint16_t local_id, uint8_t *alias);
 static error_return_t Luos_IsALuosCmd(container_t *container, uint8_t cmd, uint16_t size);
+static void Luos_UpdateMsgStat(container_t *container, error_return_t result);
+static error_return_t Luos_SendChunk(container_t *container, msg_t *msg, uint8_t *data, uint16_t remaining_size);
+static uint8_t Luos_IsBulkTarget(msg_t *msg);
+static error_return_t Luos_SendBulkData(container_t *container, msg_t *msg, void *bin_data, uint16_t size);
+static error_return_t Luos_WaitBulkAck(container_t *container, uint16_t size, uint16_t next, bulk_ack_t *ack);
+static void Luos_StartBulkSession(container_t *container, msg_t *input);
+static bulk_session_t *Luos_GetBulkSession(container_t *container, msg_t *msg);
+static uint8_t Luos_IsBulkChunk(bulk_session_t *session, msg_t *msg);
+static error_return_t Luos_ReceiveBulkData(container_t *container, bulk_session_t *session, msg_t *msg, void *bin_data);
 
 /******************************************************************************
  * @brief Luos init must be call in project init
@@ -48,6 +76,8 @@ void Luos_Init(void)
     container_number = 0;
     memset(&luos_stats.unmap[0], 0, sizeof(luos_stats_t));
     Robus_Init(&luos_stats.memory);
+    // Luos managed commands have a high priority
+    MsgAlloc_SetHighPriorityCmdNb(ASK_PUB_CMD);
 }
 /******************************************************************************
  * @brief Luos Loop must be call in project loop
@@ -152,6 +182,8 @@ static error_return_t Luos_IsALuosCmd(container_t *container, uint8_t cmd, uint1
     case RTB_CMD:
     case WRITE_ALIAS:
     case UPDATE_PUB:
+    case BULK_START:
+    case BULK_ACK:
         return SUCCEED;
         break;
 
@@ -159,6 +191,7 @@ static error_return_t Luos_IsALuosCmd(container_t *container, uint8_t cmd, uint1
     case LUOS_REVISION:
     case NODE_UUID:
     case LUOS_STATISTICS:
+    case ROBUS_STATISTICS:
         if (size == 0)
         {
             return SUCCEED;
@@ -226,6 +259,8 @@ static error_return_t Luos_MsgHandler(container_t *container, msg_t *input)
                     container_table[i].ll_container->id = base_id + i;
                 }
             }
+            // update reception filters with the new IDs
+            Trgt_UpdateFilters();
         case 0:
             // send back a local routing table
             output_msg.header.cmd = RTB_CMD;
@@ -303,6 +338,19 @@ static error_return_t Luos_MsgHandler(container_t *container, msg_t *input)
             consume = SUCCEED;
         }
         break;
+    case ROBUS_STATISTICS:
+        if (input->header.size == 0)
+        {
+            msg_t output;
+            output.header.cmd = ROBUS_STATISTICS;
+            output.header.target_mode = ID;
+            output.header.size = sizeof(robus_stats_t);
+            output.header.target = input->header.source;
+            memcpy(output.data, Robus_GetStats()->unmap, sizeof(robus_stats_t));
+            Luos_SendMsg(container, &output);
+            consume = SUCCEED;
+        }
+        break;
     case WRITE_ALIAS:
         // Make a clean copy with full \0 at the end.
         memset(container->alias, '\0', MAX_ALIAS_SIZE);
@@ -341,6 +389,15 @@ static error_return_t Luos_MsgHandler(container_t *container, msg_t *input)
         container->auto_refresh.last_update = LuosHAL_GetSystick();
         consume = SUCCEED;
         break;
+    case BULK_START:
+        // Data chunks are coming, prepare their reception
+        Luos_StartBulkSession(container, input);
+        consume = SUCCEED;
+        break;
+    case BULK_ACK:
+        // Nobody wait for this acknowledgment anymore
+        consume = SUCCEED;
+        break;
     default:
         break;
     }
@@ -507,6 +564,7 @@ container_t *Luos_CreateContainer(CONT_CB cont_cb, uint8_t type, const char *ali
     container->node_statistics = &luos_stats;
     container->ll_container->ll_stat.max_collision_retry = &container->statistics.max_collision_retry;
     container->ll_container->ll_stat.max_nak_retry = &container->statistics.max_nak_retry;
+    container->ll_container->ll_stat.msg_drop_nbr = &container->statistics.msg_drop_nbr;
 
     container_number++;
     return container;
@@ -525,11 +583,102 @@ error_return_t Luos_SendMsg(container_t *container, msg_t *msg)
         // There is no container specified here, take the first one
         container = &container_table[0];
     }
-    if (Robus_SendMsg(container->ll_container, msg) != SUCCEED)
+    result = Robus_SendMsg(container->ll_container, msg);
+    Luos_UpdateMsgStat(container, result);
+    return result;
+}
+/******************************************************************************
+ * @brief Queue a msg to send through network without waiting for its transmission
+ * @param Container who send
+ * @param Message to send, it can be reused as soon as this function return
+ * @param tx_cb function called at the end of the transmission, can be NULL
+ * @param tx_id pointer to save the message identifier used by Luos_GetTxStatus, can be NULL
+ * @return error FAILED if the transmission queue is full
+ * @warning tx_cb is called by the transmission queue from Luos_Loop but also from
+ *          any blocking send (Luos_SendMsg, Luos_SendData...) of any container waiting
+ *          for its own message. It have to be short, it can queue other messages with
+ *          Luos_SendMsgAsync but it must not call blocking sends or Luos_Loop.
+ ******************************************************************************/
+error_return_t Luos_SendMsgAsync(container_t *container, msg_t *msg, TX_CB tx_cb, uint16_t *tx_id)
+{
+    error_return_t result = SUCCEED;
+    if (container == 0)
     {
-        container->ll_container->ll_stat.fail_msg_nbr++;
+        // There is no container specified here, take the first one
+        container = &container_table[0];
+    }
+    // Keep the order with the pending aggregated messages
+    if (Robus_FlushAggregation() == FAILED)
+    {
+        // The transmission queue is full, if this message have been reserved into the allocator release it
+        MsgAlloc_CancelMsg(msg);
         result = FAILED;
     }
+    else
+    {
+        result = Robus_SendMsgAsync(container->ll_container, msg, tx_cb, tx_id);
+    }
+    Luos_UpdateMsgStat(container, result);
+    return result;
+}
+/******************************************************************************
+ * @brief Send msg through network packed with the other ones sent to the same node
+ * @param Container who send
+ * @param Message to send, it can be reused as soon as this function return
+ * @return error FAILED if the transmission queue is full
+ ******************************************************************************/
+error_return_t Luos_SendMsgAggregated(container_t *container, msg_t *msg)
+{
+    error_return_t result = SUCCEED;
+    uint16_t node_id = 0;
+    if (container == 0)
+    {
+        // There is no container specified here, take the first one
+        container = &container_table[0];
+    }
+    if (msg->header.target_mode == ID)
+    {
+        node_id = RoutingTB_NodeIDFromID(msg->header.target);
+    }
+    if (node_id == 0)
+    {
+        // We don't know the node of the target, send it alone
+        return Luos_SendMsgAsync(container, msg, NULL, NULL);
+    }
+    result = Robus_AggregateMsg(container->ll_container, node_id, msg);
+    Luos_UpdateMsgStat(container, result);
+    return result;
+}
+/******************************************************************************
+ * @brief Send the pending aggregated messages without waiting for the end of the window
+ * @param None
+ * @return error FAILED if the transmission queue is full
+ ******************************************************************************/
+error_return_t Luos_FlushAggregation(void)
+{
+    return Robus_FlushAggregation();
+}
+/******************************************************************************
+ * @brief get the transmission status of a message sent with Luos_SendMsgAsync
+ * @param tx_id message identifier given by Luos_SendMsgAsync
+ * @return tx_status_t
+ ******************************************************************************/
+tx_status_t Luos_GetTxStatus(uint16_t tx_id)
+{
+    return Robus_GetTxStatus(tx_id);
+}
+/******************************************************************************
+ * @brief update the sent message statistics of a container
+ * @param Container who send
+ * @param result of the send
+ * @return None
+ ******************************************************************************/
+static void Luos_UpdateMsgStat(container_t *container, error_return_t result)
+{
+    if (result != SUCCEED)
+    {
+        container->ll_container->ll_stat.fail_msg_nbr++;
+    }
     container->ll_container->ll_stat.msg_nbr++;
 
     if (container->ll_container->ll_stat.msg_nbr == 0xFF)
@@ -538,8 +687,44 @@ error_return_t Luos_SendMsg(container_t *container, msg_t *msg)
     }
 
     container->statistics.msg_fail_ratio = (uint8_t)(((uint32_t)container->ll_container->ll_stat.fail_msg_nbr * 100) / container->ll_container->ll_stat.msg_nbr);
-
-    return result;
+}
+/******************************************************************************
+ * @brief Get a message directly from the allocator to avoid any copy of localhost messages
+ * @param size of the data of the message, up to MAX_FRAME_DATA_SIZE
+ * @param reserved_msg pointer to the message to fill and send using Luos_SendMsg
+ * @return FAILED if there is no space available
+ ******************************************************************************/
+error_return_t Luos_ReserveMsg(uint16_t size, msg_t **reserved_msg)
+{
+    return MsgAlloc_ReserveMsg(size, reserved_msg);
+}
+/******************************************************************************
+ * @brief release a reserved message without sending it
+ * @param msg reserved message
+ * @return None
+ ******************************************************************************/
+void Luos_CancelMsg(msg_t *msg)
+{
+    MsgAlloc_CancelMsg(msg);
+}
+/******************************************************************************
+ * @brief keep a received message valid after the end of its treatment
+ * @param msg message received by the container
+ * @return FAILED if this message can't be pinned
+ * @warning Pinned messages are never overwritten, incoming messages are dropped until they are unpinned.
+ ******************************************************************************/
+error_return_t Luos_PinMsg(msg_t *msg)
+{
+    return MsgAlloc_PinMsg(msg);
+}
+/******************************************************************************
+ * @brief release a pinned message
+ * @param msg pinned message
+ * @return FAILED if this message is not pinned
+ ******************************************************************************/
+error_return_t Luos_UnpinMsg(msg_t *msg)
+{
+    return MsgAlloc_UnpinMsg(msg);
 }
 /******************************************************************************
  * @brief read last msg from buffer for a container
@@ -549,20 +734,58 @@ error_return_t Luos_SendMsg(container_t *container, msg_t *msg)
  ******************************************************************************/
 error_return_t Luos_ReadMsg(container_t *container, msg_t **returned_msg)
 {
-    error_return_t error = SUCCEED;
-    while (error == SUCCEED)
+    while (MsgAlloc_PullMsg(container->ll_container, returned_msg) == SUCCEED)
     {
-        error = MsgAlloc_PullMsg(container->ll_container, returned_msg);
         // check if the content of this message need to be managed by Luos and do it if it is.
-        if ((Luos_MsgHandler(container, *returned_msg) == FAILED) & (error == SUCCEED))
+        if (Luos_MsgHandler(container, *returned_msg) == FAILED)
         {
             // This message is for the user, pass it to the user.
             return SUCCEED;
         }
+        // Luos CMD are executed only once, clear the tasks of other containers
         MsgAlloc_ClearMsgFromLuosTasks(*returned_msg);
     }
     return FAILED;
 }
+/******************************************************************************
+ * @brief read all pending msg of a container from buffer in one pass
+ * @param container who receive the messages we are looking for
+ * @param returned_msgs table filled with the messages in arrival order
+ * @param max_nbr size of the returned_msgs table, the only limit of the number of messages
+ * @return number of messages available into returned_msgs
+ * @warning Returned messages are pinned as a single batch, release it using Luos_ReleaseMsgBatch.
+ * Reading again before the release add the new messages to the pending batch. While a batch is
+ * pending reception can't overwrite it, incoming messages are dropped if msg_buffer is full up to it.
+ ******************************************************************************/
+uint16_t Luos_ReadMsgBatch(container_t *container, msg_t **returned_msgs, uint16_t max_nbr)
+{
+    uint16_t nbr = MsgAlloc_PullMsgBatch(container->ll_container, returned_msgs, max_nbr);
+    uint16_t user_nbr = 0;
+    for (uint16_t i = 0; i < nbr; i++)
+    {
+        // check if the content of this message need to be managed by Luos and do it if it is.
+        if (Luos_MsgHandler(container, returned_msgs[i]) == FAILED)
+        {
+            // This message is for the user, pass it to the user.
+            returned_msgs[user_nbr++] = returned_msgs[i];
+        }
+        else
+        {
+            // Luos CMD are executed only once, clear the tasks of other containers
+            MsgAlloc_ClearMsgFromLuosTasks(returned_msgs[i]);
+        }
+    }
+    return user_nbr;
+}
+/******************************************************************************
+ * @brief release the messages read using Luos_ReadMsgBatch
+ * @param container who read the messages
+ * @return FAILED if this container have no pending batch
+ ******************************************************************************/
+error_return_t Luos_ReleaseMsgBatch(container_t *container)
+{
+    return MsgAlloc_UnpinMsgBatch(container->ll_container);
+}
 /******************************************************************************
  * @brief read last msg from buffer from a specific id container
  * @param container who receive the message we are looking for
@@ -610,20 +833,30 @@ error_return_t Luos_ReadFromContainer(container_t *container, short id, msg_t **
 /******************************************************************************
  * @brief Send large among of data and formating to send into multiple msg
  * @param Container who send
- * @param Message to send
+ * @param Message to send, with an IDACK or NODEIDACK target_mode the chunks are sent with a bulk transfer
  * @param Pointer to the message data table
  * @param Size of the data to transmit
  * @return error
+ * @warning This is a blocking function. A bulk transfer return only when all
+ *          the chunks are acknowledged or after NBR_BULK_RETRY windows without
+ *          acknowledgment, each window waiting up to BULK_ACK_TIMEOUT_MS. Only
+ *          Robus runs during this time, the other containers of this node don't
+ *          get their messages until the next Luos_Loop.
  ******************************************************************************/
 error_return_t Luos_SendData(container_t *container, msg_t *msg, void *bin_data, uint16_t size)
 {
     // Compute number of message needed to send this data
     uint16_t msg_number = 1;
     uint16_t sent_size = 0;
-    if (size > MAX_DATA_MSG_SIZE)
+    if ((size > MAX_FRAME_DATA_SIZE) && (Luos_IsBulkTarget(msg) == true))
     {
-        msg_number = (size / MAX_DATA_MSG_SIZE);
-        msg_number += (msg_number * MAX_DATA_MSG_SIZE < size);
+        // Acknowledge the chunks by windows instead of one by one
+        return Luos_SendBulkData(container, msg, bin_data, size);
+    }
+    if (size > MAX_FRAME_DATA_SIZE)
+    {
+        msg_number = (size / MAX_FRAME_DATA_SIZE);
+        msg_number += (msg_number * MAX_FRAME_DATA_SIZE < size);
     }
 
     // Send messages one by one
@@ -631,21 +864,17 @@ error_return_t Luos_SendData(container_t *container, msg_t *msg, void *bin_data,
     {
         // Compute chunk size
         uint16_t chunk_size = 0;
-        if ((size - sent_size) > MAX_DATA_MSG_SIZE)
+        if ((size - sent_size) > MAX_FRAME_DATA_SIZE)
         {
-            chunk_size = MAX_DATA_MSG_SIZE;
+            chunk_size = MAX_FRAME_DATA_SIZE;
         }
         else
         {
             chunk_size = size - sent_size;
         }
 
-        // Copy data into message
-        memcpy(msg->data, (uint8_t *)bin_data + sent_size, chunk_size);
-        msg->header.size = size - sent_size;
-
         // Send message
-        if (Luos_SendMsg(container, msg) == FAILED)
+        if (Luos_SendChunk(container, msg, (uint8_t *)bin_data + sent_size, size - sent_size) == FAILED)
         {
             // This message fail stop transmission and return an error
             return FAILED;
@@ -656,6 +885,36 @@ error_return_t Luos_SendData(container_t *container, msg_t *msg, void *bin_data,
     }
     return SUCCEED;
 }
+/******************************************************************************
+ * @brief Send a chunk of large data
+ * @param Container who send
+ * @param Message giving the header of the chunk
+ * @param Pointer to the chunk data
+ * @param Size of the data remaining to send from this chunk
+ * @return error
+ ******************************************************************************/
+static error_return_t Luos_SendChunk(container_t *container, msg_t *msg, uint8_t *data, uint16_t remaining_size)
+{
+    msg_t *chunk_msg = msg;
+    uint16_t chunk_size = remaining_size;
+    if (chunk_size > MAX_FRAME_DATA_SIZE)
+    {
+        chunk_size = MAX_FRAME_DATA_SIZE;
+    }
+    if (chunk_size > MAX_DATA_MSG_SIZE)
+    {
+        // msg is too small for this chunk, build it into msg_buffer
+        if (MsgAlloc_ReserveMsg(chunk_size, &chunk_msg) == FAILED)
+        {
+            return FAILED;
+        }
+        memcpy(chunk_msg->header.unmap, msg->header.unmap, sizeof(header_t));
+    }
+    // Copy data into message
+    memcpy(chunk_msg->data, data, chunk_size);
+    chunk_msg->header.size = remaining_size;
+    return Luos_SendMsg(container, chunk_msg);
+}
 /******************************************************************************
  * @brief receive a multi msg data
  * @param Container who receive
@@ -674,9 +933,15 @@ error_return_t Luos_ReceiveData(container_t *container, msg_t *msg, void *bin_da
     {
         return FAILED;
     }
+    // check if this chunk is part of a bulk transfer
+    bulk_session_t *session = Luos_GetBulkSession(container, msg);
+    if (session != NULL)
+    {
+        return Luos_ReceiveBulkData(container, session, msg, bin_data);
+    }
 
     // check message integrity
-    if ((last_msg_size > 0) && (last_msg_size - MAX_DATA_MSG_SIZE > msg->header.size))
+    if ((last_msg_size > 0) && (last_msg_size - MAX_FRAME_DATA_SIZE > msg->header.size))
     {
         // we miss a message (a part of the data),
         // reset session and return an error.
@@ -687,9 +952,9 @@ error_return_t Luos_ReceiveData(container_t *container, msg_t *msg, void *bin_da
 
     // Get chunk size
     uint16_t chunk_size = 0;
-    if (msg->header.size > MAX_DATA_MSG_SIZE)
+    if (msg->header.size > MAX_FRAME_DATA_SIZE)
     {
-        chunk_size = MAX_DATA_MSG_SIZE;
+        chunk_size = MAX_FRAME_DATA_SIZE;
     }
     else
     {
@@ -704,7 +969,7 @@ error_return_t Luos_ReceiveData(container_t *container, msg_t *msg, void *bin_da
     last_msg_size = msg->header.size;
 
     // Check end of data
-    if (!(msg->header.size > MAX_DATA_MSG_SIZE))
+    if (!(msg->header.size > MAX_FRAME_DATA_SIZE))
     {
         // Data collection finished, reset buffer session state
         data_size[id] = 0;
@@ -713,6 +978,259 @@ error_return_t Luos_ReceiveData(container_t *container, msg_t *msg, void *bin_da
     }
     return FAILED;
 }
+/******************************************************************************
+ * @brief check if large data can be sent with a bulk transfer
+ * @param Message to send
+ * @return true if the target acknowledge the messages and is on another node
+ ******************************************************************************/
+static uint8_t Luos_IsBulkTarget(msg_t *msg)
+{
+    // Recep_NodeConcerned is made for the reception IT, use the target tables without side effect
+    switch (msg->header.target_mode)
+    {
+    case IDACK:
+        return (Trgt_IdConcerned(msg->header.target) == false);
+    case NODEIDACK:
+        return (msg->header.target != Robus_GetNode()->node_id);
+    default:
+        return false;
+    }
+}
+/******************************************************************************
+ * @brief Send large data with a sliding window of chunks, only the missing ones are sent again
+ * @param Container who send
+ * @param Message to send with an IDACK or NODEIDACK target_mode
+ * @param Pointer to the message data table
+ * @param Size of the data to transmit
+ * @return error
+ ******************************************************************************/
+static error_return_t Luos_SendBulkData(container_t *container, msg_t *msg, void *bin_data, uint16_t size)
+{
+    msg_t start_msg;
+    bulk_start_t start;
+    bulk_ack_t ack;
+    uint8_t ack_mode = msg->header.target_mode;
+    uint8_t chunk_mode = (ack_mode == IDACK) ? ID : NODEID;
+    uint16_t chunk_nb = BULK_CHUNK_NB(size);
+    uint16_t next = 0;
+    uint32_t received = 0;
+    uint16_t last = 0;
+    uint8_t retry = 0;
+    error_return_t result = SUCCEED;
+
+    // Announce the transfer
+    start.size = size;
+    start.cmd = msg->header.cmd;
+    start_msg.header.cmd = BULK_START;
+    start_msg.header.target_mode = ack_mode;
+    start_msg.header.target = msg->header.target;
+    start_msg.header.size = sizeof(bulk_start_t);
+    memcpy(start_msg.data, start.unmap, sizeof(bulk_start_t));
+    if (Luos_SendMsg(container, &start_msg) == FAILED)
+    {
+        return FAILED;
+    }
+    while (next < chunk_nb)
+    {
+        // Find the last missing chunk of the window, it will ask for an acknowledgment
+        last = next + BULK_WINDOW_NB - 1;
+        if (last >= chunk_nb)
+        {
+            last = chunk_nb - 1;
+        }
+        while ((last > next) && (received & ((uint32_t)1 << (last - next))))
+        {
+            last--;
+        }
+        // Send the missing chunks of the window
+        for (uint16_t chunk = next; chunk <= last; chunk++)
+        {
+            if (received & ((uint32_t)1 << (chunk - next)))
+            {
+                continue;
+            }
+            uint16_t offset = chunk * MAX_FRAME_DATA_SIZE;
+            msg->header.target_mode = (chunk == last) ? ack_mode : chunk_mode;
+            if (Luos_SendChunk(container, msg, (uint8_t *)bin_data + offset, size - offset) == FAILED)
+            {
+                result = FAILED;
+                break;
+            }
+        }
+        if (result == FAILED)
+        {
+            break;
+        }
+        if (Luos_WaitBulkAck(container, size, next, &ack) == SUCCEED)
+        {
+            next = ack.next;
+            received = ack.received;
+            retry = 0;
+        }
+        else if (++retry > NBR_BULK_RETRY)
+        {
+            // The receiver don't answer anymore
+            result = FAILED;
+            break;
+        }
+    }
+    msg->header.target_mode = ack_mode;
+    return result;
+}
+/******************************************************************************
+ * @brief Wait for the acknowledgment of a bulk transfer
+ * @param Container who send the data
+ * @param Size of the data
+ * @param First chunk not acknowledged yet
+ * @param ack received acknowledgment
+ * @return FAILED if there is no acknowledgment before BULK_ACK_TIMEOUT_MS
+ * @warning This function blocks the caller, and the containers of this node, up to BULK_ACK_TIMEOUT_MS.
+ ******************************************************************************/
+static error_return_t Luos_WaitBulkAck(container_t *container, uint16_t size, uint16_t next, bulk_ack_t *ack)
+{
+    msg_t ack_msg;
+    error_return_t result = FAILED;
+    uint32_t timestamp = LuosHAL_GetSystick();
+    // The acknowledgment is caught by Robus, this wait can happen during a Luos_Loop and must not pull luos tasks
+    Robus_CatchMsg(container->ll_container, BULK_ACK, &ack_msg);
+    while ((LuosHAL_GetSystick() - timestamp) < BULK_ACK_TIMEOUT_MS)
+    {
+        Robus_Loop();
+        if (Robus_MsgCaught())
+        {
+            memcpy(ack->unmap, ack_msg.data, sizeof(bulk_ack_t));
+            if ((ack->size == size) && (ack->next >= next))
+            {
+                result = SUCCEED;
+                break;
+            }
+            // This is the acknowledgment of a previous window, skip it
+            Robus_CatchMsg(container->ll_container, BULK_ACK, &ack_msg);
+        }
+    }
+    Robus_CatchMsg(NULL, 0, NULL);
+    return result;
+}
+/******************************************************************************
+ * @brief prepare the reception of a bulk transfer
+ * @param Container who receive
+ * @param input BULK_START message
+ * @return None
+ ******************************************************************************/
+static void Luos_StartBulkSession(container_t *container, msg_t *input)
+{
+    bulk_start_t start;
+    uint16_t id = Luos_GetContainerIndex(container);
+    if (id == 0xFFFF)
+    {
+        return;
+    }
+    memcpy(start.unmap, input->data, sizeof(bulk_start_t));
+    // A new transfer replace the one in progress for this container
+    bulk_rx[id].source = input->header.source;
+    bulk_rx[id].cmd = start.cmd;
+    bulk_rx[id].size = start.size;
+    bulk_rx[id].next = 0;
+    bulk_rx[id].received = 0;
+    bulk_rx[id].done = false;
+}
+/******************************************************************************
+ * @brief find the bulk transfer of a received chunk
+ * @param Container who receive
+ * @param msg received chunk
+ * @return bulk session or NULL if this chunk is not part of a bulk transfer
+ ******************************************************************************/
+static bulk_session_t *Luos_GetBulkSession(container_t *container, msg_t *msg)
+{
+    uint16_t id = Luos_GetContainerIndex(container);
+    if ((id == 0xFFFF) || (bulk_rx[id].size == 0))
+    {
+        return NULL;
+    }
+    if ((bulk_rx[id].done == true) && ((LuosHAL_GetSystick() - bulk_rx[id].date) >= BULK_DONE_KEEP_MS))
+    {
+        // The sender can't retry anymore, free the session
+        bulk_rx[id].size = 0;
+        return NULL;
+    }
+    if ((bulk_rx[id].source != msg->header.source) || (bulk_rx[id].cmd != msg->header.cmd))
+    {
+        return NULL;
+    }
+    if ((bulk_rx[id].done == true) && (Luos_IsBulkChunk(&bulk_rx[id], msg) == false))
+    {
+        // This is not a chunk sent again but a new data, free the session
+        bulk_rx[id].size = 0;
+        return NULL;
+    }
+    return &bulk_rx[id];
+}
+/******************************************************************************
+ * @brief check if a message can be a chunk of a bulk transfer
+ * @param session of the bulk transfer
+ * @param msg received message
+ * @return true if the remaining size of this message give the place of a chunk
+ ******************************************************************************/
+static uint8_t Luos_IsBulkChunk(bulk_session_t *session, msg_t *msg)
+{
+    return ((msg->header.size <= session->size) && (((session->size - msg->header.size) % MAX_FRAME_DATA_SIZE) == 0));
+}
+/******************************************************************************
+ * @brief receive a chunk of a bulk transfer and acknowledge it if the sender ask for it
+ * @param Container who receive
+ * @param session of the bulk transfer
+ * @param Message chunk received
+ * @param pointer to data
+ * @return SUCCEED when all the chunks are received
+ ******************************************************************************/
+static error_return_t Luos_ReceiveBulkData(container_t *container, bulk_session_t *session, msg_t *msg, void *bin_data)
+{
+    msg_t ack_msg;
+    bulk_ack_t ack;
+    if ((session->done == false) && (Luos_IsBulkChunk(session, msg) == true))
+    {
+        // The remaining size give the place of this chunk
+        uint16_t offset = session->size - msg->header.size;
+        uint16_t chunk = offset / MAX_FRAME_DATA_SIZE;
+        if ((chunk >= session->next) && ((chunk - session->next) < 32))
+        {
+            uint16_t chunk_size = msg->header.size;
+            if (chunk_size > MAX_FRAME_DATA_SIZE)
+            {
+                chunk_size = MAX_FRAME_DATA_SIZE;
+            }
+            memcpy((uint8_t *)bin_data + offset, msg->data, chunk_size);
+            session->received |= (uint32_t)1 << (chunk - session->next);
+            // Slide the window over the received chunks
+            while (session->received & 1)
+            {
+                session->received >>= 1;
+                session->next++;
+            }
+        }
+    }
+    if ((msg->header.target_mode == IDACK) || (msg->header.target_mode == NODEIDACK))
+    {
+        // The sender wait for an acknowledgment
+        ack.size = session->size;
+        ack.next = session->next;
+        ack.received = session->received;
+        ack_msg.header.cmd = BULK_ACK;
+        ack_msg.header.target_mode = ID;
+        ack_msg.header.target = msg->header.source;
+        ack_msg.header.size = sizeof(bulk_ack_t);
+        memcpy(ack_msg.data, ack.unmap, sizeof(bulk_ack_t));
+        Luos_SendMsg(container, &ack_msg);
+    }
+    if ((session->done == false) && (session->next == BULK_CHUNK_NB(session->size)))
+    {
+        // All the chunks are received, keep acknowledging them in case the last acknowledgment is lost
+        session->done = true;
+        session->date = LuosHAL_GetSystick();
+        return SUCCEED;
+    }
+    return FAILED;
+}
 /******************************************************************************
  * @brief Send datas of a streaming channel
  * @param Container who send
@@ -856,7 +1374,7 @@ static error_return_t Luos_ReadAlias(uint16_t local_id, uint8_t *alias)
  ******************************************************************************/
 void Luos_SetBaudrate(uint32_t baudrate)
 {
-    LuosHAL_ComInit(baudrate);
+    Robus_SetBaudrate(baudrate);
 }
 /******************************************************************************
  * @brief send network bauderate
@@ -874,6 +1392,17 @@ void Luos_SendBaudrate(container_t *container, uint32_t baudrate)
     msg.header.size = sizeof(uint32_t);
     Robus_SendMsg(container->ll_container, &msg);
 }
+/******************************************************************************
+ * @brief find the highest baudrate handled by all nodes, must be called by the detecting container
+ * @param container sending request
+ * @param baudrates candidates sorted from the preferred one
+ * @param baudrate_nbr number of candidates
+ * @return the baudrate used by the network at the end of the negotiation
+ ******************************************************************************/
+uint32_t Luos_NegotiateBaudrate(container_t *container, const uint32_t *baudrates, uint8_t baudrate_nbr)
+{
+    return Robus_NegotiateBaudrate(container->ll_container, baudrates, baudrate_nbr);
+}
 /******************************************************************************
  * @brief set id of a container trough the network
  * @param container sending request
@@ -906,6 +1435,113 @@ uint16_t Luos_NbrAvailableMsg(void)
 {
     return MsgAlloc_LuosTasksNbr();
 }
+/******************************************************************************
+ * @brief enable or disable the messages coalescing of a container
+ * @param container
+ * @param enable : if true a received message replace the pending one with the same source and cmd
+ * @return None
+ ******************************************************************************/
+void Luos_SetCoalescing(container_t *container, uint8_t enable)
+{
+    container->ll_container->coalescing = enable;
+}
+/******************************************************************************
+ * @brief select the priority of the messages received by a container
+ * @param container
+ * @param priority : HIGH_PRIORITY messages are treated before NORMAL_PRIORITY ones and have reserved space
+ * @return None
+ ******************************************************************************/
+void Luos_SetPriority(container_t *container, msg_priority_t priority)
+{
+    container->ll_container->priority = priority;
+}
+/******************************************************************************
+ * @brief limit the received messages a container can keep pending
+ * @param container
+ * @param min_task : number of pending messages always available for this container
+ * @param max_task : maximum number of pending messages, 0 for no limit
+ * @param max_byte : maximum size of pending messages, 0 for no limit
+ * @return None
+ ******************************************************************************/
+void Luos_SetQuota(container_t *container, uint8_t min_task, uint8_t max_task, uint16_t max_byte)
+{
+    LUOS_ASSERT((min_task <= MAX_MSG_NB) && ((max_task == 0) || (min_task <= max_task)));
+    container->ll_container->quota_min_task = min_task;
+    container->ll_container->quota_max_task = max_task;
+    container->ll_container->quota_max_byte = max_byte;
+}
+/******************************************************************************
+ * @brief select the cmds a container receive, messages with other cmds are dropped at reception
+ * @param container
+ * @param cmd_list : table of accepted cmds, NULL to accept all cmds
+ * @param cmd_nbr : number of cmds into cmd_list
+ * @return None
+ ******************************************************************************/
+void Luos_SetCmdFilter(container_t *container, const uint8_t *cmd_list, uint16_t cmd_nbr)
+{
+    uint32_t cmd_filter[CMD_FILTER_SIZE];
+    uint16_t i;
+    if (cmd_list == NULL)
+    {
+        memset(cmd_filter, 0xFF, sizeof(cmd_filter));
+    }
+    else
+    {
+        memset(cmd_filter, 0, sizeof(cmd_filter));
+        // Luos cmds are always needed
+        for (i = 0; i < ASK_PUB_CMD; i++)
+        {
+            cmd_filter[i >> 5] |= ((uint32_t)1 << (i & 0x1F));
+        }
+        for (i = ROBUS_STATISTICS; i < LUOS_PROTOCOL_NB; i++)
+        {
+            cmd_filter[i >> 5] |= ((uint32_t)1 << (i & 0x1F));
+        }
+        for (i = 0; i < cmd_nbr; i++)
+        {
+            cmd_filter[cmd_list[i] >> 5] |= ((uint32_t)1 << (cmd_list[i] & 0x1F));
+        }
+    }
+    Trgt_SetCmdFilter(container->ll_container, cmd_filter);
+}
+/******************************************************************************
+ * @brief add a container to a multicast group, MULTICAST messages targeting this group will be received by it
+ * @param container
+ * @param group : multicast group
+ * @return error_return_t : FAILED if the container is already in MAX_MULTICAST_ADDRESS groups
+ ******************************************************************************/
+error_return_t Luos_JoinMulticastGroup(container_t *container, uint16_t group)
+{
+    return Trgt_AddMulticastTarget(container->ll_container, group);
+}
+/******************************************************************************
+ * @brief remove a container from a multicast group
+ * @param container
+ * @param group : multicast group
+ * @return error_return_t : FAILED if the container is not in this group
+ ******************************************************************************/
+error_return_t Luos_LeaveMulticastGroup(container_t *container, uint16_t group)
+{
+    return Trgt_RemoveMulticastTarget(container->ll_container, group);
+}
+/******************************************************************************
+ * @brief select the behavior of the node when there is no more space for a received message
+ * @param policy : DROP_OLDEST, DROP_NEWEST or BACKPRESSURE
+ * @return None
+ ******************************************************************************/
+void Luos_SetOverflowPolicy(overflow_policy_t policy)
+{
+    MsgAlloc_SetOverflowPolicy(policy);
+}
+/******************************************************************************
+ * @brief select the waiting time before retrying a transmission after a collision
+ * @param policy : ID_BACKOFF, EXPONENTIAL_BACKOFF or PRIORITY_BACKOFF
+ * @return None
+ ******************************************************************************/
+void Luos_SetBackoffPolicy(backoff_policy_t policy)
+{
+    Transmit_SetBackoffPolicy(policy);
+}
 /******************************************************************************
  * @brief Get tick number
  * @param None
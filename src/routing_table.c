@@ -128,6 +128,27 @@ luos_type_t RoutingTB_TypeFromID(uint16_t id)
     }
     return -1;
 }
+/******************************************************************************
+ * @brief  Return the node ID hosting a container
+ * @param id container look at
+ * @return node ID or 0 if the container is not found
+ ******************************************************************************/
+uint16_t RoutingTB_NodeIDFromID(uint16_t id)
+{
+    uint16_t node_id = 0;
+    for (uint16_t i = 0; i <= last_routing_table_entry; i++)
+    {
+        if (routing_table[i].mode == NODE)
+        {
+            node_id = routing_table[i].node_id;
+        }
+        else if ((routing_table[i].mode == CONTAINER) && (routing_table[i].id == id))
+        {
+            return node_id;
+        }
+    }
+    return 0;
+}
 /******************************************************************************
  * @brief  Return container type from alias
  * @param alias container look at
@@ -0,0 +1,268 @@
+/******************************************************************************
+ * @file luosHAL
+ * @brief Host hardware abstraction layer used by the tests and benchmarks
+ * @author Luos
+ * @version 0.0.0
+ * @note The bus is simulated: every transmitted byte is received back by this
+ *       node as on the real half duplex line, and the end of each frame raise
+ *       the reception timeout. No other node answer unless a test feed it.
+ ******************************************************************************/
+#include "luos_hal.h"
+
+#include <string.h>
+#include <time.h>
+#include "context.h"
+#include "reception.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+uint32_t host_uuid[3] = {0x484F5354, 0, 1};
+static uint8_t rx_enable = 1;
+static uint16_t last_tx_size = 0;
+static HOST_TX_HOOK tx_hook = 0;
+static host_bus_stats_t bus_stats;
+static uint8_t flash[0x400];
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+static uint64_t HostHAL_GetNs(void);
+
+/******************************************************************************
+ * @brief Luos HAL general initialisation
+ * @param None
+ * @return None
+ ******************************************************************************/
+void LuosHAL_Init(void)
+{
+    memset(&bus_stats, 0, sizeof(host_bus_stats_t));
+}
+/******************************************************************************
+ * @brief There is no interrupt on host
+ * @param Enable
+ * @return None
+ ******************************************************************************/
+void LuosHAL_SetIrqState(uint8_t Enable)
+{
+    (void)Enable;
+}
+/******************************************************************************
+ * @brief Luos HAL general systick tick at 1ms
+ * @param None
+ * @return tick Counter
+ ******************************************************************************/
+uint32_t LuosHAL_GetSystick(void)
+{
+    return (uint32_t)(HostHAL_GetNs() / 1000000);
+}
+/******************************************************************************
+ * @brief microsecond clock, used with US_TICK_HAL
+ * @param None
+ * @return us Counter
+ ******************************************************************************/
+uint32_t LuosHAL_GetUsTick(void)
+{
+    return (uint32_t)(HostHAL_GetNs() / 1000);
+}
+/******************************************************************************
+ * @brief Luos HAL Initialize the simulated bus
+ * @param Baudrate
+ * @return None
+ ******************************************************************************/
+void LuosHAL_ComInit(uint32_t Baudrate)
+{
+    (void)Baudrate;
+}
+/******************************************************************************
+ * @brief Tx enable/disable relative to com
+ * @param Enable
+ * @return None
+ ******************************************************************************/
+void LuosHAL_SetTxState(uint8_t Enable)
+{
+    (void)Enable;
+}
+/******************************************************************************
+ * @brief Rx enable/disable relative to com
+ * @param Enable
+ * @return None
+ ******************************************************************************/
+void LuosHAL_SetRxState(uint8_t Enable)
+{
+    rx_enable = Enable;
+}
+/******************************************************************************
+ * @brief put a frame on the simulated bus
+ * @param pointer data to send
+ * @param size of data to send
+ * @return collision, always 0 on host
+ ******************************************************************************/
+uint8_t LuosHAL_ComTransmit(unsigned char *data, uint16_t size)
+{
+    bus_stats.frame_nbr++;
+    bus_stats.byte_nbr += size;
+    last_tx_size = size;
+    // Receive our own bytes as on the real bus, until the reception is disabled
+    for (uint16_t i = 0; (i < size) && rx_enable; i++)
+    {
+        ctx.rx.callback(&data[i]);
+    }
+    if (tx_hook)
+    {
+        tx_hook(data, size);
+    }
+    return 0;
+}
+/******************************************************************************
+ * @brief End of the transmission, the line goes idle
+ * @param None
+ * @return None
+ ******************************************************************************/
+void LuosHAL_ComTxComplete(void)
+{
+    if (last_tx_size > 1)
+    {
+        Recep_Timeout();
+    }
+}
+/******************************************************************************
+ * @brief There is no Tx lock detection on host
+ * @param Enable
+ * @return None
+ ******************************************************************************/
+void LuosHAL_SetTxLockDetecState(uint8_t Enable)
+{
+    (void)Enable;
+}
+/******************************************************************************
+ * @brief The line is never locked on host
+ * @param None
+ * @return Lock status
+ ******************************************************************************/
+uint8_t LuosHAL_GetTxLockState(void)
+{
+    return 0;
+}
+/******************************************************************************
+ * @brief There is no PTP line on host
+ * @param PTP branch
+ * @return None
+ ******************************************************************************/
+void LuosHAL_SetPTPDefaultState(uint8_t PortNbr)
+{
+    (void)PortNbr;
+}
+/******************************************************************************
+ * @brief There is no PTP line on host
+ * @param PTP branch
+ * @return None
+ ******************************************************************************/
+void LuosHAL_SetPTPReverseState(uint8_t PortNbr)
+{
+    (void)PortNbr;
+}
+/******************************************************************************
+ * @brief There is no PTP line on host
+ * @param PTP branch
+ * @return None
+ ******************************************************************************/
+void LuosHAL_PushPTP(uint8_t PortNbr)
+{
+    (void)PortNbr;
+}
+/******************************************************************************
+ * @brief There is no other node on the PTP lines
+ * @param PTP branch
+ * @return Line state
+ ******************************************************************************/
+uint8_t LuosHAL_GetPTPState(uint8_t PortNbr)
+{
+    (void)PortNbr;
+    return 0;
+}
+/******************************************************************************
+ * @brief Reference bitwise CRC, polynomial 0x0007 MSB first
+ * @param data pointer to the byte to add
+ * @param crc pointer to the current crc value
+ * @return None
+ ******************************************************************************/
+void LuosHAL_ComputeCRC(uint8_t *data, uint8_t *crc)
+{
+    uint16_t dbyte = *data;
+    uint16_t value = *(uint16_t *)crc;
+    value ^= dbyte << 8;
+    for (uint8_t j = 0; j < 8; ++j)
+    {
+        uint16_t mix = value & 0x8000;
+        value = (value << 1);
+        if (mix)
+        {
+            value = value ^ 0x0007;
+        }
+    }
+    *(uint16_t *)crc = value;
+}
+/******************************************************************************
+ * @brief Write the aliases into a RAM flash
+ * @param addr address into the flash
+ * @param size of data to write
+ * @param data to write
+ * @return None
+ ******************************************************************************/
+void LuosHAL_FlashWriteLuosMemoryInfo(uint32_t addr, uint16_t size, uint8_t *data)
+{
+    uint32_t offset = (addr - ADDRESS_ALIASES_FLASH) % sizeof(flash);
+    if (offset + size <= sizeof(flash))
+    {
+        memcpy(&flash[offset], data, size);
+    }
+}
+/******************************************************************************
+ * @brief Read the aliases from a RAM flash
+ * @param addr address into the flash
+ * @param size of data to read
+ * @param data read
+ * @return None
+ ******************************************************************************/
+void LuosHAL_FlashReadLuosMemoryInfo(uint32_t addr, uint16_t size, uint8_t *data)
+{
+    uint32_t offset = (addr - ADDRESS_ALIASES_FLASH) % sizeof(flash);
+    if (offset + size <= sizeof(flash))
+    {
+        memcpy(data, &flash[offset], size);
+    }
+    else
+    {
+        memset(data, 0, size);
+    }
+}
+/******************************************************************************
+ * @brief spy the frames put on the bus
+ * @param hook called after each transmission, NULL to remove it
+ * @return None
+ ******************************************************************************/
+void HostHAL_SetTxHook(HOST_TX_HOOK hook)
+{
+    tx_hook = hook;
+}
+/******************************************************************************
+ * @brief get the simulated bus statistics, they can be reset with a memset
+ * @param None
+ * @return bus statistics
+ ******************************************************************************/
+host_bus_stats_t *HostHAL_GetBusStats(void)
+{
+    return &bus_stats;
+}
+/******************************************************************************
+ * @brief monotonic clock of the host
+ * @param None
+ * @return time in ns
+ ******************************************************************************/
+static uint64_t HostHAL_GetNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+ * @file luosHAL
+ * @brief Host hardware abstraction layer used by the tests and benchmarks
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#ifndef _LUOSHAL_H_
+#define _LUOSHAL_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define MCUFREQ 48000000
+#define LUOS_UUID host_uuid
+#define ADDRESS_ALIASES_FLASH 0x0800C000
+
+typedef void (*HOST_TX_HOOK)(const uint8_t *data, uint16_t size);
+
+/*
+ * Frames put on the simulated bus
+ */
+typedef struct
+{
+    uint32_t frame_nbr; /*!< Number of frames sent, acknowledgments included. */
+    uint32_t byte_nbr;  /*!< Number of bytes sent. */
+} host_bus_stats_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+extern uint32_t host_uuid[3];
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+void LuosHAL_Init(void);
+void LuosHAL_SetIrqState(uint8_t Enable);
+uint32_t LuosHAL_GetSystick(void);
+uint32_t LuosHAL_GetUsTick(void);
+void LuosHAL_ComInit(uint32_t Baudrate);
+void LuosHAL_SetTxState(uint8_t Enable);
+void LuosHAL_SetRxState(uint8_t Enable);
+uint8_t LuosHAL_ComTransmit(unsigned char *data, uint16_t size);
+void LuosHAL_ComTxComplete(void);
+void LuosHAL_SetTxLockDetecState(uint8_t Enable);
+uint8_t LuosHAL_GetTxLockState(void);
+void LuosHAL_SetPTPDefaultState(uint8_t PortNbr);
+void LuosHAL_SetPTPReverseState(uint8_t PortNbr);
+void LuosHAL_PushPTP(uint8_t PortNbr);
+uint8_t LuosHAL_GetPTPState(uint8_t PortNbr);
+void LuosHAL_ComputeCRC(uint8_t *data, uint8_t *crc);
+void LuosHAL_FlashWriteLuosMemoryInfo(uint32_t addr, uint16_t size, uint8_t *data);
+void LuosHAL_FlashReadLuosMemoryInfo(uint32_t addr, uint16_t size, uint8_t *data);
+
+// Host only
+void HostHAL_SetTxHook(HOST_TX_HOOK hook);
+host_bus_stats_t *HostHAL_GetBusStats(void);
+
+#endif /* _LUOSHAL_H_ */
@@ -0,0 +1,168 @@
+/******************************************************************************
+ * @file test_aggregation
+ * @brief Aggregated frames test, and bus throughput of small messages with and without aggregation
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include <string.h>
+#include <stdbool.h>
+#include "luos.h"
+#include "robus.h"
+#include "context.h"
+#include "target.h"
+#include "luos_hal.h"
+#include "test_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define MSG_NB      300
+#define FRAME_MAX   MSG_NB
+#define FRAME_SIZE  (sizeof(header_t) + MAX_FRAME_DATA_SIZE + 2)
+#define REMOTE_NODE 2
+#define REMOTE_ID   20 // ID of the first of the 2 containers of the remote node
+// Messages up to MIN_RATIO_SIZE data bytes must get at least MIN_RATIO times the throughput they have alone
+#define MIN_RATIO_SIZE 4
+#define MIN_RATIO      2.0
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint8_t frames[FRAME_MAX][FRAME_SIZE];
+static uint16_t frame_sizes[FRAME_MAX];
+static uint16_t frame_nbr;
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief keep the frames sent to give them to the remote node
+ * @param data sent
+ * @param size of data
+ * @return None
+ ******************************************************************************/
+static void Capture_Tx(const uint8_t *data, uint16_t size)
+{
+    if ((size > 1) && (frame_nbr < FRAME_MAX))
+    {
+        memcpy(frames[frame_nbr], data, size);
+        frame_sizes[frame_nbr++] = size;
+    }
+}
+/******************************************************************************
+ * @brief send MSG_NB small messages to the containers of the remote node
+ * @param aggregated send them with Robus_AggregateMsg or alone
+ * @param size of the messages data
+ * @return None
+ ******************************************************************************/
+static void Send_Msgs(uint8_t aggregated, uint8_t size)
+{
+    msg_t msg;
+    revision_t revision = {{{0, 0, 0}}};
+    Luos_Init();
+    container_t *container = Luos_CreateContainer(0, VOID_MOD, "tx", revision);
+    container->ll_container->id = 1;
+    Trgt_UpdateFilters();
+    ctx.node.node_id = 1;
+    memset(HostHAL_GetBusStats(), 0, sizeof(host_bus_stats_t));
+    frame_nbr = 0;
+    HostHAL_SetTxHook(Capture_Tx);
+    for (uint16_t i = 0; i < MSG_NB; i++)
+    {
+        msg.header.target_mode = ID;
+        msg.header.target = REMOTE_ID + (i & 1);
+        msg.header.cmd = ASK_PUB_CMD + 1 + (i % 3);
+        msg.header.size = size;
+        for (uint8_t j = 0; j < size; j++)
+        {
+            msg.data[j] = (uint8_t)(i + j);
+        }
+        if (aggregated)
+        {
+            while (Robus_AggregateMsg(container->ll_container, REMOTE_NODE, &msg) == FAILED)
+            {
+                Robus_Loop();
+            }
+        }
+        else
+        {
+            while (Robus_SendMsgAsync(container->ll_container, &msg, NULL, NULL) == FAILED)
+            {
+                Robus_Loop();
+            }
+        }
+        Robus_Loop();
+    }
+    while (Robus_FlushAggregation() == FAILED)
+    {
+        Robus_Loop();
+    }
+    Test_WaitTxEnd();
+    HostHAL_SetTxHook(0);
+}
+/******************************************************************************
+ * @brief give the captured frames to the remote node and check its containers get all the messages
+ * @param size of the messages data
+ * @return number of messages received
+ ******************************************************************************/
+static uint16_t Receive_Msgs(uint8_t size)
+{
+    container_t *containers[2];
+    msg_t *msg;
+    uint16_t msg_nbr = 0;
+    revision_t revision = {{{0, 0, 0}}};
+    Luos_Init();
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        containers[i] = Luos_CreateContainer(0, VOID_MOD, "rx", revision);
+        containers[i]->ll_container->id = REMOTE_ID + i;
+    }
+    Trgt_UpdateFilters();
+    ctx.node.node_id = REMOTE_NODE;
+    for (uint16_t i = 0; i < frame_nbr; i++)
+    {
+        Test_FeedBytes(frames[i], frame_sizes[i]);
+        Luos_Loop();
+        for (uint8_t j = 0; j < 2; j++)
+        {
+            while (Luos_ReadMsg(containers[j], &msg) == SUCCEED)
+            {
+                TEST_ASSERT(msg->header.size == size);
+                TEST_ASSERT(msg->header.source == 1);
+                for (uint8_t k = 1; k < size; k++)
+                {
+                    TEST_ASSERT(msg->data[k] == (uint8_t)(msg->data[0] + k));
+                }
+                msg_nbr++;
+            }
+        }
+    }
+    return msg_nbr;
+}
+
+int main(void)
+{
+    const uint8_t sizes[] = {1, 4, 8, 16};
+    for (uint8_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        host_bus_stats_t alone;
+        host_bus_stats_t aggregated;
+        Send_Msgs(false, sizes[i]);
+        alone = *HostHAL_GetBusStats();
+        TEST_ASSERT(alone.frame_nbr == MSG_NB);
+        TEST_ASSERT(Receive_Msgs(sizes[i]) == MSG_NB);
+        Send_Msgs(true, sizes[i]);
+        aggregated = *HostHAL_GetBusStats();
+        TEST_ASSERT(Receive_Msgs(sizes[i]) == MSG_NB);
+        // The same payload is sent, so the effective throughput ratio is the bus time ratio
+        double ratio = (double)TEST_BUS_BITS(alone.frame_nbr, alone.byte_nbr) / TEST_BUS_BITS(aggregated.frame_nbr, aggregated.byte_nbr);
+        printf("%2d data bytes: %3u frames %5u bytes alone, %3u frames %5u bytes aggregated, effective throughput x%.2f\n",
+               sizes[i], alone.frame_nbr, alone.byte_nbr, aggregated.frame_nbr, aggregated.byte_nbr, ratio);
+        if (sizes[i] <= MIN_RATIO_SIZE)
+        {
+            TEST_ASSERT(ratio >= MIN_RATIO);
+        }
+    }
+    return Test_End("test_aggregation");
+}
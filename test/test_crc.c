@@ -0,0 +1,86 @@
+/******************************************************************************
+ * @file test_crc
+ * @brief Crc_Update test against the HAL CRC, and bytes per cycle benchmark of both
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include "crc.h"
+#include "luos_hal.h"
+#include "test_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BUFFER_SIZE 1024
+#define BENCH_NB    2000
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief compute a CRC byte per byte with the HAL
+ * @param crc initial value
+ * @param buf data
+ * @param len size of data
+ * @return crc
+ ******************************************************************************/
+static uint16_t Hal_Crc(uint16_t crc, const uint8_t *buf, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        LuosHAL_ComputeCRC((uint8_t *)&buf[i], (uint8_t *)&crc);
+    }
+    return crc;
+}
+
+int main(void)
+{
+    static uint8_t buffer[BUFFER_SIZE + 8];
+    const uint16_t bench_sizes[] = {sizeof(header_t) + MAX_DATA_MSG_SIZE + 2, BUFFER_SIZE};
+    volatile uint16_t crc = 0;
+
+    srand(1);
+    for (uint16_t i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = (uint8_t)rand();
+    }
+    // Bit exact for every size and alignment
+    for (uint16_t offset = 0; offset < 8; offset++)
+    {
+        for (uint16_t len = 0; len <= 300; len++)
+        {
+            TEST_ASSERT(Crc_Update(CRC_INIT_VAL, &buffer[offset], len) == Hal_Crc(CRC_INIT_VAL, &buffer[offset], len));
+        }
+    }
+    // Incremental updates give the same result as a single one
+    uint16_t reference = Hal_Crc(CRC_INIT_VAL, buffer, BUFFER_SIZE);
+    for (uint16_t split = 0; split <= BUFFER_SIZE; split += 37)
+    {
+        uint16_t value = Crc_Update(CRC_INIT_VAL, buffer, split);
+        TEST_ASSERT(Crc_Update(value, &buffer[split], BUFFER_SIZE - split) == reference);
+    }
+
+    for (uint16_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++)
+    {
+        uint16_t size = bench_sizes[i];
+        uint64_t start = Test_GetCycles();
+        for (uint16_t j = 0; j < BENCH_NB; j++)
+        {
+            crc = Hal_Crc(CRC_INIT_VAL, buffer, size);
+        }
+        uint64_t hal_cycles = Test_GetCycles() - start;
+        start = Test_GetCycles();
+        for (uint16_t j = 0; j < BENCH_NB; j++)
+        {
+            crc = Crc_Update(CRC_INIT_VAL, buffer, size);
+        }
+        uint64_t update_cycles = Test_GetCycles() - start;
+        double total = (double)size * BENCH_NB;
+        printf("%4d bytes: LuosHAL_ComputeCRC per byte %.3f, Crc_Update %.3f bytes/%s (x%.1f)\n", size, total / hal_cycles, total / update_cycles, TEST_CYCLE_UNIT, (double)hal_cycles / update_cycles);
+    }
+    (void)crc;
+    return Test_End("test_crc");
+}
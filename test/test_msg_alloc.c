@@ -0,0 +1,138 @@
+/******************************************************************************
+ * @file test_msg_alloc
+ * @brief msg_tasks queue benchmark, the pull cost must not depend on MAX_MSG_NB
+ *
+ * The pull cost is measured with REF_DEPTH pending messages, a depth each
+ * MAX_MSG_NB build can hold, and with half of msg_tasks pending. Each round is
+ * timed alone and the cheapest one is kept, so the result don't depend on the
+ * preemptions of the host. The build of REF_MSG_NB save its cost into
+ * REF_FILE, the other builds check their costs against it.
+ *
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include <string.h>
+#include "luos.h"
+#include "context.h"
+#include "msg_alloc.h"
+#include "target.h"
+#include "test_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define ROUND_NB  10000
+#define REF_DEPTH 4
+#define MAX_RATIO 2.0
+// Floor of the reference cost, smaller costs are in the noise of the timer
+#define MIN_COST 10.0
+
+#ifndef REF_MSG_NB
+#define REF_MSG_NB 8
+#endif
+#ifndef REF_FILE
+#define REF_FILE "build/test_msg_alloc.ref"
+#endif
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief measure the cheapest MsgAlloc_PullMsgToInterpret cost with a given number of pending messages
+ * @param frame to receive
+ * @param size of the frame
+ * @param depth number of pending messages to pull
+ * @return TEST_CYCLE_UNIT per pull
+ ******************************************************************************/
+static double Bench_Pull(const uint8_t *frame, uint16_t size, uint16_t depth)
+{
+    uint64_t best = UINT64_MAX;
+    msg_t *msg;
+    for (uint16_t round = 0; round < ROUND_NB; round++)
+    {
+        for (uint16_t i = 0; i < depth; i++)
+        {
+            Test_FeedBytes(frame, size);
+        }
+        uint16_t count = 0;
+        uint64_t start = Test_GetCycles();
+        while (MsgAlloc_PullMsgToInterpret(&msg) == SUCCEED)
+        {
+            count++;
+        }
+        uint64_t cycles = Test_GetCycles() - start;
+        TEST_ASSERT(count == depth);
+        if (cycles < best)
+        {
+            best = cycles;
+        }
+    }
+    return (double)best / depth;
+}
+/******************************************************************************
+ * @brief check that a cost is not much bigger than a reference one
+ * @param cost to check
+ * @param reference cost
+ * @return None
+ ******************************************************************************/
+static void Check_Ratio(double cost, double reference)
+{
+    if (reference < MIN_COST)
+    {
+        reference = MIN_COST;
+    }
+    TEST_ASSERT(cost <= reference * MAX_RATIO);
+}
+int main(void)
+{
+    uint8_t frame[sizeof(header_t) + MAX_FRAME_DATA_SIZE + 2];
+    uint8_t data[4] = {1, 2, 3, 4};
+    revision_t revision = {{{0, 0, 0}}};
+
+    Luos_Init();
+    container_t *container = Luos_CreateContainer(0, VOID_MOD, "bench", revision);
+    container->ll_container->id = 2;
+    Trgt_UpdateFilters();
+    ctx.node.node_id = 1;
+
+    uint16_t size = Test_BuildFrame(frame, 2, ID, 3, ASK_PUB_CMD, data, sizeof(data));
+    double ref_cost = Bench_Pull(frame, size, REF_DEPTH);
+    double half_cost = Bench_Pull(frame, size, MAX_MSG_NB / 2);
+    printf("MAX_MSG_NB %4d: %5.1f %s/MsgAlloc_PullMsgToInterpret with %d msg, %5.1f with %d msg\n",
+           MAX_MSG_NB, ref_cost, TEST_CYCLE_UNIT, REF_DEPTH, half_cost, MAX_MSG_NB / 2);
+    // The pull cost must not depend on the number of pending messages...
+    Check_Ratio(half_cost, ref_cost);
+    // ...nor on the size of msg_tasks
+    FILE *ref_file;
+    if (MAX_MSG_NB == REF_MSG_NB)
+    {
+        ref_file = fopen(REF_FILE, "w");
+        TEST_ASSERT(ref_file != NULL);
+        if (ref_file != NULL)
+        {
+            fprintf(ref_file, "%f\n", ref_cost);
+            fclose(ref_file);
+        }
+    }
+    else
+    {
+        double reference = 0.0;
+        ref_file = fopen(REF_FILE, "r");
+        if ((ref_file != NULL) && (fscanf(ref_file, "%lf", &reference) == 1))
+        {
+            printf("MAX_MSG_NB %4d: x%.2f the cost of MAX_MSG_NB %d\n", MAX_MSG_NB, ref_cost / reference, REF_MSG_NB);
+            Check_Ratio(ref_cost, reference);
+        }
+        else
+        {
+            printf("MAX_MSG_NB %4d: no MAX_MSG_NB %d cost into %s\n", MAX_MSG_NB, REF_MSG_NB, REF_FILE);
+            test_fail_nbr++;
+        }
+        if (ref_file != NULL)
+        {
+            fclose(ref_file);
+        }
+    }
+    return Test_End("test_msg_alloc");
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+ * @file test_mtu
+ * @brief Large data transfer test, and throughput for the MAX_FRAME_DATA_SIZE of this build
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include <string.h>
+#include "luos.h"
+#include "context.h"
+#include "target.h"
+#include "luos_hal.h"
+#include "test_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define DATA_SIZE  4000
+#define FRAME_MAX  (DATA_SIZE / MAX_DATA_MSG_SIZE + 1)
+#define FRAME_SIZE (sizeof(header_t) + MAX_FRAME_DATA_SIZE + 2)
+#define REMOTE_ID  20
+#define ROUND_NB   100
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint8_t frames[FRAME_MAX][FRAME_SIZE];
+static uint16_t frame_sizes[FRAME_MAX];
+static uint16_t frame_nbr;
+static uint8_t tx_data[DATA_SIZE];
+static uint8_t rx_data[DATA_SIZE];
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief keep the frames sent to give them to the remote node
+ * @param data sent
+ * @param size of data
+ * @return None
+ ******************************************************************************/
+static void Capture_Tx(const uint8_t *data, uint16_t size)
+{
+    if ((size > 1) && (frame_nbr < FRAME_MAX))
+    {
+        memcpy(frames[frame_nbr], data, size);
+        frame_sizes[frame_nbr++] = size;
+    }
+}
+/******************************************************************************
+ * @brief give the captured frames to the remote node
+ * @param container of the remote node
+ * @return number of complete data received
+ ******************************************************************************/
+static uint16_t Receive_Data(container_t *container)
+{
+    msg_t *msg;
+    uint16_t done = 0;
+    for (uint16_t i = 0; i < frame_nbr; i++)
+    {
+        Test_FeedBlocks(frames[i], frame_sizes[i], frame_sizes[i]);
+        Luos_Loop();
+        while (Luos_ReadMsg(container, &msg) == SUCCEED)
+        {
+            if (Luos_ReceiveData(container, msg, rx_data) == SUCCEED)
+            {
+                done++;
+            }
+        }
+    }
+    return done;
+}
+
+int main(void)
+{
+    msg_t msg;
+    revision_t revision = {{{0, 0, 0}}};
+    for (uint16_t i = 0; i < DATA_SIZE; i++)
+    {
+        tx_data[i] = (uint8_t)(i * 13 + 1);
+    }
+
+    // Send the data to a container of a remote node
+    Luos_Init();
+    container_t *container = Luos_CreateContainer(0, VOID_MOD, "tx", revision);
+    container->ll_container->id = 1;
+    Trgt_UpdateFilters();
+    ctx.node.node_id = 1;
+    memset(HostHAL_GetBusStats(), 0, sizeof(host_bus_stats_t));
+    frame_nbr = 0;
+    HostHAL_SetTxHook(Capture_Tx);
+    msg.header.target_mode = ID;
+    msg.header.target = REMOTE_ID;
+    msg.header.cmd = ASK_PUB_CMD + 1;
+    TEST_ASSERT(Luos_SendData(container, &msg, tx_data, DATA_SIZE) == SUCCEED);
+    Test_WaitTxEnd();
+    HostHAL_SetTxHook(0);
+    host_bus_stats_t bus = *HostHAL_GetBusStats();
+    TEST_ASSERT(bus.frame_nbr == (DATA_SIZE + MAX_FRAME_DATA_SIZE - 1) / MAX_FRAME_DATA_SIZE);
+    TEST_ASSERT(frame_nbr == bus.frame_nbr);
+
+    // Receive it on the remote node
+    Luos_Init();
+    container = Luos_CreateContainer(0, VOID_MOD, "rx", revision);
+    container->ll_container->id = REMOTE_ID;
+    Trgt_UpdateFilters();
+    ctx.node.node_id = 2;
+    TEST_ASSERT(Receive_Data(container) == 1);
+    TEST_ASSERT(memcmp(tx_data, rx_data, DATA_SIZE) == 0);
+    uint64_t start = Test_GetCycles();
+    for (uint16_t i = 0; i < ROUND_NB; i++)
+    {
+        TEST_ASSERT(Receive_Data(container) == 1);
+    }
+    uint64_t rx_cycles = Test_GetCycles() - start;
+
+    printf("MTU %4d: %2u frames %5u bytes on the bus, %5.1f kB/s effective at %d baud, reception %.2f %s/byte\n",
+           MAX_FRAME_DATA_SIZE, bus.frame_nbr, bus.byte_nbr,
+           (double)DATA_SIZE * DEFAULTBAUDRATE / TEST_BUS_BITS(bus.frame_nbr, bus.byte_nbr) / 1000,
+           DEFAULTBAUDRATE, (double)rx_cycles / ((uint32_t)DATA_SIZE * ROUND_NB), TEST_CYCLE_UNIT);
+    return Test_End("test_mtu");
+}
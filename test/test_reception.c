@@ -0,0 +1,228 @@
+/******************************************************************************
+ * @file test_reception
+ * @brief Recep_ProcessBlock test against the byte per byte reception, and benchmark of both
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include <string.h>
+#include "luos.h"
+#include "context.h"
+#include "msg_alloc.h"
+#include "reception.h"
+#include "target.h"
+#include "luos_hal.h"
+#include "test_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define FRAME_NB   9
+#define FRAME_SIZE (sizeof(header_t) + MAX_FRAME_DATA_SIZE + 2)
+#define LOG_SIZE   4096
+#define BENCH_NB   2000
+
+/*
+ * Everything the node did with the received frames
+ */
+typedef struct
+{
+    uint8_t log[LOG_SIZE]; /*!< Acknowledgments sent and messages stored. */
+    uint16_t size;         /*!< Size of log. */
+    uint16_t crc_error_nbr;
+    uint16_t filter_drop_nbr;
+} rx_result_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint8_t frames[FRAME_NB][FRAME_SIZE];
+static uint16_t frame_sizes[FRAME_NB];
+static rx_result_t *result;
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief log the acknowledgments sent by the node
+ * @param data sent
+ * @param size of data
+ * @return None
+ ******************************************************************************/
+static void Log_Tx(const uint8_t *data, uint16_t size)
+{
+    if ((size == 1) && (result->size + 2 <= LOG_SIZE))
+    {
+        result->log[result->size++] = 'A';
+        result->log[result->size++] = data[0];
+    }
+}
+/******************************************************************************
+ * @brief log the messages stored by the node
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void Log_Msgs(void)
+{
+    msg_t *msg;
+    while (MsgAlloc_PullMsgToInterpret(&msg) == SUCCEED)
+    {
+        uint16_t size = sizeof(header_t) + ((msg->header.size > MAX_FRAME_DATA_SIZE) ? MAX_FRAME_DATA_SIZE : msg->header.size);
+        TEST_ASSERT(result->size + 1 + size <= LOG_SIZE);
+        result->log[result->size++] = 'M';
+        memcpy(&result->log[result->size], (uint8_t *)msg, size);
+        result->size += size;
+    }
+}
+/******************************************************************************
+ * @brief start a node with 2 containers, ID 2 and 3
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void Node_Init(void)
+{
+    revision_t revision = {{{0, 0, 0}}};
+    Luos_Init();
+    container_t *container = Luos_CreateContainer(0, VOID_MOD, "rx", revision);
+    container->ll_container->id = 2;
+    container = Luos_CreateContainer(0, STATE_MOD, "rx", revision);
+    container->ll_container->id = 3;
+    Trgt_UpdateFilters();
+    ctx.node.node_id = 1;
+}
+/******************************************************************************
+ * @brief prepare the frames captured from other nodes
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void Frames_Init(void)
+{
+    uint8_t data[MAX_FRAME_DATA_SIZE];
+    for (uint16_t i = 0; i < MAX_FRAME_DATA_SIZE; i++)
+    {
+        data[i] = (uint8_t)(i * 7 + 3);
+    }
+    frame_sizes[0] = Test_BuildFrame(frames[0], 2, ID, 9, ASK_PUB_CMD, data, 4);
+    frame_sizes[1] = Test_BuildFrame(frames[1], 3, IDACK, 9, ASK_PUB_CMD + 1, data, 20);
+    // Wrong CRC asking for an acknowledgment
+    frame_sizes[2] = Test_BuildFrame(frames[2], 2, IDACK, 9, ASK_PUB_CMD, data, 12);
+    frames[2][frame_sizes[2] - 1] ^= 0x5A;
+    // Not for this node
+    frame_sizes[3] = Test_BuildFrame(frames[3], 7, ID, 9, ASK_PUB_CMD, data, 30);
+    frame_sizes[4] = Test_BuildFrame(frames[4], BROADCAST_VAL, BROADCAST, 9, ASK_PUB_CMD + 2, data, 10);
+    frame_sizes[5] = Test_BuildFrame(frames[5], STATE_MOD, TYPE, 9, ASK_PUB_CMD, data, 1);
+    frame_sizes[6] = Test_BuildFrame(frames[6], 2, ID, 9, ASK_PUB_CMD, data, MAX_FRAME_DATA_SIZE);
+    // First frame of a bigger data
+    frame_sizes[7] = Test_BuildFrame(frames[7], 3, IDACK, 9, ASK_PUB_CMD, data, MAX_FRAME_DATA_SIZE + 100);
+    // Frame cut by a timeout
+    frame_sizes[8] = Test_BuildFrame(frames[8], 2, ID, 9, ASK_PUB_CMD, data, 40) - 20;
+}
+/******************************************************************************
+ * @brief receive all the frames and log what the node did
+ * @param block_size size of the Recep_ProcessBlock blocks, 0 to use the byte callback
+ * @param rx_result result to fill
+ * @return None
+ ******************************************************************************/
+static void Receive_Frames(uint16_t block_size, rx_result_t *rx_result)
+{
+    memset(rx_result, 0, sizeof(rx_result_t));
+    result = rx_result;
+    Node_Init();
+    uint16_t crc_error_nbr = ctx.stats.crc_error_nbr;
+    uint16_t filter_drop_nbr = ctx.stats.filter_drop_nbr;
+    HostHAL_SetTxHook(Log_Tx);
+    for (uint16_t i = 0; i < FRAME_NB; i++)
+    {
+        if (block_size == 0)
+        {
+            Test_FeedBytes(frames[i], frame_sizes[i]);
+        }
+        else
+        {
+            Test_FeedBlocks(frames[i], frame_sizes[i], block_size);
+        }
+        Log_Msgs();
+    }
+    HostHAL_SetTxHook(0);
+    rx_result->crc_error_nbr = ctx.stats.crc_error_nbr - crc_error_nbr;
+    rx_result->filter_drop_nbr = ctx.stats.filter_drop_nbr - filter_drop_nbr;
+}
+/******************************************************************************
+ * @brief measure the reception cost of a frame
+ * @param size of the frame data
+ * @param block_size size of the Recep_ProcessBlock blocks, 0 to use the byte callback
+ * @return TEST_CYCLE_UNIT per frame
+ ******************************************************************************/
+static double Bench_Reception(uint16_t size, uint16_t block_size)
+{
+    uint8_t data[MAX_FRAME_DATA_SIZE] = {0};
+    uint8_t frame[FRAME_SIZE];
+    msg_t *msg;
+    uint64_t cycles = 0;
+    uint16_t frame_size = Test_BuildFrame(frame, 2, ID, 9, ASK_PUB_CMD, data, size);
+    Node_Init();
+    for (uint16_t i = 0; i < BENCH_NB; i++)
+    {
+        uint64_t start = Test_GetCycles();
+        if (block_size == 0)
+        {
+            Test_FeedBytes(frame, frame_size);
+        }
+        else
+        {
+            Test_FeedBlocks(frame, frame_size, block_size);
+        }
+        cycles += Test_GetCycles() - start;
+        TEST_ASSERT(MsgAlloc_PullMsgToInterpret(&msg) == SUCCEED);
+    }
+    return (double)cycles / BENCH_NB;
+}
+
+int main(void)
+{
+    const uint16_t block_sizes[] = {1, 2, 5, 16, 64, FRAME_SIZE};
+    const uint16_t bench_sizes[] = {4, 32, MAX_DATA_MSG_SIZE};
+    static rx_result_t byte_result;
+    static rx_result_t block_result;
+
+    Frames_Init();
+    // Byte per byte reference
+    Receive_Frames(0, &byte_result);
+    TEST_ASSERT(byte_result.crc_error_nbr == 1);
+    TEST_ASSERT(byte_result.filter_drop_nbr == 1);
+    uint16_t msg_nbr = 0;
+    uint16_t ack_nbr = 0;
+    for (uint16_t i = 0; i < byte_result.size;)
+    {
+        if (byte_result.log[i] == 'A')
+        {
+            ack_nbr++;
+            i += 2;
+        }
+        else
+        {
+            header_t *header = (header_t *)&byte_result.log[i + 1];
+            msg_nbr++;
+            i += 1 + sizeof(header_t) + ((header->size > MAX_FRAME_DATA_SIZE) ? MAX_FRAME_DATA_SIZE : header->size);
+        }
+    }
+    TEST_ASSERT(msg_nbr == 6);
+    TEST_ASSERT(ack_nbr == 3);
+    // The block reception must do exactly the same whatever the block size
+    for (uint16_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i++)
+    {
+        Receive_Frames(block_sizes[i], &block_result);
+        TEST_ASSERT(block_result.size == byte_result.size);
+        TEST_ASSERT(memcmp(block_result.log, byte_result.log, byte_result.size) == 0);
+        TEST_ASSERT(block_result.crc_error_nbr == byte_result.crc_error_nbr);
+        TEST_ASSERT(block_result.filter_drop_nbr == byte_result.filter_drop_nbr);
+    }
+
+    for (uint16_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++)
+    {
+        double byte_cycles = Bench_Reception(bench_sizes[i], 0);
+        double block_cycles = Bench_Reception(bench_sizes[i], FRAME_SIZE);
+        printf("%3d data bytes: byte callback %7.1f, Recep_ProcessBlock %7.1f %s/frame (x%.1f)\n", bench_sizes[i], byte_cycles, block_cycles, TEST_CYCLE_UNIT, byte_cycles / block_cycles);
+    }
+    return Test_End("test_reception");
+}
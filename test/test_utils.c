@@ -0,0 +1,159 @@
+/******************************************************************************
+ * @file test_utils
+ * @brief Helpers shared by the host tests and benchmarks
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#include "test_utils.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "context.h"
+#include "reception.h"
+#include "robus.h"
+#include "timing.h"
+#include "luos_hal.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+uint16_t test_fail_nbr = 0;
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief stop the test on a Luos assertion instead of looping forever
+ * @param file where the assertion failed
+ * @param line where the assertion failed
+ * @return None
+ ******************************************************************************/
+void node_assert(char *file, uint32_t line)
+{
+    printf("LUOS_ASSERT %s:%u\n", file, line);
+    exit(2);
+}
+/******************************************************************************
+ * @brief build a frame as it is on the bus, CRC included
+ * @param frame buffer to fill, sizeof(header_t) + MAX_FRAME_DATA_SIZE + 2 bytes
+ * @param target header target
+ * @param target_mode header target_mode
+ * @param source header source
+ * @param cmd header cmd
+ * @param data to copy after the header
+ * @param size header size, only MAX_FRAME_DATA_SIZE bytes are copied if it is bigger
+ * @return frame size
+ ******************************************************************************/
+uint16_t Test_BuildFrame(uint8_t *frame, uint16_t target, uint8_t target_mode, uint16_t source, uint8_t cmd, const uint8_t *data, uint16_t size)
+{
+    header_t header;
+    uint16_t crc = 0xFFFF;
+    uint16_t data_size = (size > MAX_FRAME_DATA_SIZE) ? MAX_FRAME_DATA_SIZE : size;
+    memset(header.unmap, 0, sizeof(header_t));
+    header.target = target;
+    header.target_mode = target_mode;
+    header.source = source;
+    header.cmd = cmd;
+    header.size = size;
+    memcpy(frame, header.unmap, sizeof(header_t));
+    memcpy(&frame[sizeof(header_t)], data, data_size);
+    // Use the reference HAL CRC, not the one under test
+    for (uint16_t i = 0; i < sizeof(header_t) + data_size; i++)
+    {
+        LuosHAL_ComputeCRC(&frame[i], (uint8_t *)&crc);
+    }
+    frame[sizeof(header_t) + data_size] = (uint8_t)crc;
+    frame[sizeof(header_t) + data_size + 1] = (uint8_t)(crc >> 8);
+    return sizeof(header_t) + data_size + 2;
+}
+/******************************************************************************
+ * @brief receive a frame byte per byte, as an UART interrupt does
+ * @param frame to receive
+ * @param size of the frame
+ * @return None
+ ******************************************************************************/
+void Test_FeedBytes(const uint8_t *frame, uint16_t size)
+{
+    for (uint16_t i = 0; i < size; i++)
+    {
+        volatile uint8_t data = frame[i];
+        ctx.rx.callback(&data);
+    }
+    Recep_Timeout();
+}
+/******************************************************************************
+ * @brief receive a frame by blocks, as a DMA or idle line interrupt does
+ * @param frame to receive
+ * @param size of the frame
+ * @param block_size bytes given to each Recep_ProcessBlock call
+ * @return None
+ ******************************************************************************/
+void Test_FeedBlocks(const uint8_t *frame, uint16_t size, uint16_t block_size)
+{
+    uint16_t offset = 0;
+    while (offset < size)
+    {
+        uint16_t len = size - offset;
+        if (len > block_size)
+        {
+            len = block_size;
+        }
+        Recep_ProcessBlock(&frame[offset], len);
+        offset += len;
+    }
+    Recep_Timeout();
+}
+/******************************************************************************
+ * @brief run Robus until nothing is sent during 2 aggregation windows
+ * @param None
+ * @return None
+ ******************************************************************************/
+void Test_WaitTxEnd(void)
+{
+    deadline_t deadline;
+    uint32_t frame_nbr;
+    do
+    {
+        frame_nbr = HostHAL_GetBusStats()->frame_nbr;
+        Timing_SetDeadline(&deadline, 2 * AGGREGATION_WINDOW_US);
+        while (!Timing_IsExpired(&deadline))
+        {
+            Robus_Loop();
+        }
+    } while (frame_nbr != HostHAL_GetBusStats()->frame_nbr);
+}
+/******************************************************************************
+ * @brief read the CPU cycle counter, or a ns clock if there is none
+ * @param None
+ * @return TEST_CYCLE_UNIT counter
+ ******************************************************************************/
+uint64_t Test_GetCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+/******************************************************************************
+ * @brief print the test result
+ * @param name of the test
+ * @return process exit code
+ ******************************************************************************/
+int Test_End(const char *name)
+{
+    if (test_fail_nbr)
+    {
+        printf("%s: %u FAILED\n", name, test_fail_nbr);
+        return 1;
+    }
+    printf("%s: OK\n", name);
+    return 0;
+}
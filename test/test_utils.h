@@ -0,0 +1,52 @@
+/******************************************************************************
+ * @file test_utils
+ * @brief Helpers shared by the host tests and benchmarks
+ * @author Luos
+ * @version 0.0.0
+ ******************************************************************************/
+#ifndef _TEST_UTILS_H_
+#define _TEST_UTILS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include "config.h"
+#include "robus_struct.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_ASSERT(expr)                                                \
+    do                                                                   \
+    {                                                                    \
+        if (!(expr))                                                     \
+        {                                                                \
+            printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #expr); \
+            test_fail_nbr++;                                             \
+        }                                                                \
+    } while (0)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TEST_CYCLE_UNIT "cycle"
+#else
+#define TEST_CYCLE_UNIT "ns"
+#endif
+
+// Simulated line: 10 bits per byte, and the reception timeout (TIMEOUT_VAL bytes) between two frames
+#define TEST_BUS_BITS(frame_nbr, byte_nbr) (((uint64_t)(byte_nbr) + (uint64_t)(frame_nbr)*TIMEOUT_VAL) * 10)
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+extern uint16_t test_fail_nbr;
+
+/*******************************************************************************
+ * Function
+ ******************************************************************************/
+uint16_t Test_BuildFrame(uint8_t *frame, uint16_t target, uint8_t target_mode, uint16_t source, uint8_t cmd, const uint8_t *data, uint16_t size);
+void Test_FeedBytes(const uint8_t *frame, uint16_t size);
+void Test_FeedBlocks(const uint8_t *frame, uint16_t size, uint16_t block_size);
+void Test_WaitTxEnd(void);
+uint64_t Test_GetCycles(void);
+int Test_End(const char *name);
+
+#endif /* _TEST_UTILS_H_ */